@@ -0,0 +1 @@
+#include <assert.h>
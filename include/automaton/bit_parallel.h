@@ -0,0 +1,265 @@
+/*
+ * A bit_parallel_nfa runs a program with at most 64 consuming instructions
+ * as a Glushkov automaton whose set of active positions is one 64 bit word.
+ * Position i is the i-th consuming instruction of the program. No DFA is
+ * built, and a step is the same few table lookups, shifts and ANDs for
+ * every input character:
+ *   matched = active & accept[byte]
+ *   active = follow[0][matched & 0xff] | ... | follow[7][matched >> 56]
+ * where accept[byte] holds the positions that consume byte and follow[k][v]
+ * holds the positions reachable after the positions in byte k of matched
+ * whose bits are v. The input matches when matched meets the final
+ * positions, those from which a MATCH instruction is reachable. There is
+ * only a follow table for each byte of the word that holds a position, so
+ * a small program has small tables.
+ *
+ * The tables only depend on the program, so they are built once, in a
+ * bit_parallel_table, and shared by every engine running that program.
+ * Only programs over single byte characters are supported.
+ */
+
+#ifndef _bit_parallel_h_
+#define _bit_parallel_h_
+
+#include "automaton/closure.h"
+#include "automaton/program.h"
+#include "data_structures/sparse_set.h"
+#include "regex_types.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lex {
+
+template <typename CharT, typename Traits>
+class bit_parallel_table {
+ public:
+  using program_type = program<CharT, Traits>;
+  using mask_type = std::uint64_t;
+  using index_type = std::size_t;
+
+  static constexpr std::size_t max_positions = 64;
+
+  // This returns null if the program has too many positions or its
+  // characters are wider than a byte.
+  static std::shared_ptr<const bit_parallel_table>
+  build(const program_type& prog);
+
+  mask_type first() const {return first_;}
+  // The smallest rule matched by the empty input.
+  index_type first_rule() const {return first_rule_;}
+  mask_type accept(CharT ch) const {
+    return accept_[static_cast<unsigned char>(ch)];
+  }
+  mask_type finals() const {return finals_;}
+  mask_type follow(mask_type matched) const;
+  // The smallest rule matched after the positions in matched, which must
+  // meet finals().
+  index_type rule(mask_type matched) const;
+ private:
+  mask_type first_ {0};
+  index_type first_rule_ {thread_flags::no_rule()};
+  mask_type finals_ {0};
+  std::array<mask_type, 256> accept_ {};
+  std::vector<std::array<mask_type, 256>> follow_;
+  std::vector<index_type> rules;
+
+  // This maps an instruction closure to its positions.
+  static mask_type positions(const sparse_set<std::size_t>& list,
+      const std::vector<int>& position_of);
+};
+
+template <typename CharT, typename Traits>
+constexpr std::size_t bit_parallel_table<CharT, Traits>::max_positions;
+
+template <typename CharT, typename Traits>
+std::shared_ptr<const bit_parallel_table<CharT, Traits>>
+bit_parallel_table<CharT, Traits>::build(const program_type& prog) {
+  if (sizeof(CharT) != 1) {
+    return nullptr;
+  }
+  std::vector<int> position_of(prog.size() + 1, -1);
+  std::vector<std::size_t> pcs;
+  for (std::size_t pc = 0; pc != prog.size(); ++pc) {
+    if (prog[pc].consumes()) {
+      position_of[pc] = static_cast<int>(pcs.size());
+      pcs.push_back(pc);
+    }
+  }
+  if (pcs.size() > max_positions) {
+    return nullptr;
+  }
+
+  auto table = std::make_shared<bit_parallel_table>();
+  sparse_set<std::size_t> list(prog.size() + 1);
+  std::vector<std::size_t> stack(prog.size() + 1);
+  thread_flags flags;
+  add_closure(prog, list, stack, 0, flags);
+  table->first_ = positions(list, position_of);
+  table->first_rule_ = flags.rule;
+
+  // The follow set of each single position is spread over the tables of
+  // its byte, and each table entry is the union of its bits' sets.
+  table->rules.assign(pcs.size(), thread_flags::no_rule());
+  table->follow_.assign((pcs.size() + 7) / 8, std::array<mask_type, 256> {});
+  for (std::size_t p = 0; p != pcs.size(); ++p) {
+    list.clear();
+    flags.clear();
+    add_closure(prog, list, stack, pcs[p] + 1, flags);
+    auto follow = positions(list, position_of);
+    if (flags.matched()) {
+      table->finals_ |= mask_type{1} << p;
+      table->rules[p] = flags.rule;
+    }
+    auto& chunk = table->follow_[p / 8];
+    auto bit = std::size_t{1} << (p % 8);
+    for (std::size_t v = 0; v != 256; ++v) {
+      if (v & bit) {
+        chunk[v] |= follow;
+      }
+    }
+    for (std::size_t byte = 0; byte != 256; ++byte) {
+      auto ch = static_cast<CharT>(static_cast<unsigned char>(byte));
+      if (prog.accepts(prog[pcs[p]], ch)) {
+        table->accept_[byte] |= mask_type{1} << p;
+      }
+    }
+  }
+  return table;
+}
+
+template <typename CharT, typename Traits>
+typename bit_parallel_table<CharT, Traits>::mask_type
+bit_parallel_table<CharT, Traits>::positions(
+    const sparse_set<std::size_t>& list,
+    const std::vector<int>& position_of) {
+  mask_type mask {0};
+  for (auto pc : list) {
+    if (position_of[pc] >= 0) {
+      mask |= mask_type{1} << position_of[pc];
+    }
+  }
+  return mask;
+}
+
+template <typename CharT, typename Traits>
+inline typename bit_parallel_table<CharT, Traits>::mask_type
+bit_parallel_table<CharT, Traits>::follow(mask_type matched) const {
+  mask_type next {0};
+  for (std::size_t k = 0; k != follow_.size(); ++k) {
+    next |= follow_[k][(matched >> (8 * k)) & 0xff];
+  }
+  return next;
+}
+
+template <typename CharT, typename Traits>
+typename bit_parallel_table<CharT, Traits>::index_type
+bit_parallel_table<CharT, Traits>::rule(mask_type matched) const {
+  auto rule = thread_flags::no_rule();
+  for (auto m = matched & finals_; m != 0; m &= m - 1) {
+    auto p = static_cast<std::size_t>(__builtin_ctzll(m));
+    if (rules[p] < rule) {
+      rule = rules[p];
+    }
+  }
+  return rule;
+}
+
+// The engine has the same interface as the other engines: update() takes
+// one character at a time and match() finds the longest match.
+template <typename CharT, typename Traits>
+class bit_parallel_nfa {
+ public:
+  using value_type = CharT;
+  using table_type = bit_parallel_table<CharT, Traits>;
+  using table_pointer = std::shared_ptr<const table_type>;
+  using mask_type = typename table_type::mask_type;
+  using index_type = std::size_t;
+
+  explicit bit_parallel_nfa(table_pointer t)
+    : table {std::move(t)} {
+    initialize();
+  }
+
+  match_state state() const;
+  // This is the smallest rule matched by the input so far.
+  index_type rule() const {return rule_;}
+
+  void update(value_type ch) {
+    auto matched = active & table->accept(ch);
+    active = table->follow(matched);
+    rule_ = matched & table->finals()? table->rule(matched) : 
+      thread_flags::no_rule();
+  }
+  void initialize() {
+    active = table->first();
+    rule_ = table->first_rule();
+  }
+
+  // This returns the end of the longest match at the start of the range.
+  // If nothing matches, begin is returned. The second form also sets rule
+  // to the rule of that match, or to thread_flags::no_rule().
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end);
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end, index_type& rule);
+ private:
+  table_pointer table;
+  mask_type active;
+  index_type rule_;
+};
+
+template <typename CharT, typename Traits>
+match_state bit_parallel_nfa<CharT, Traits>::state() const {
+  if (rule_ != thread_flags::no_rule()) {
+    return active? match_state::MATCH : match_state::FINAL_MATCH;
+  }
+  return active? match_state::UNDECIDED : match_state::MISMATCH;
+}
+
+template <typename CharT, typename Traits>
+template <typename ForwardIt>
+ForwardIt bit_parallel_nfa<CharT, Traits>::match(ForwardIt begin,
+    ForwardIt end) {
+  index_type rule;
+  return match(begin, end, rule);
+}
+
+// The loop keeps the masks in locals, and the rule is only looked up once
+// the longest match is known.
+template <typename CharT, typename Traits>
+template <typename ForwardIt>
+ForwardIt bit_parallel_nfa<CharT, Traits>::match(ForwardIt begin,
+    ForwardIt end, index_type& rule) {
+  initialize();
+  auto accepted = begin;
+  mask_type last {0};
+  mask_type m {0};
+  const auto& t = *table;
+  auto finals = t.finals();
+  auto a = active;
+  auto seek = begin;
+  while (a && seek != end) {
+    m = a & t.accept(*seek);
+    a = t.follow(m);
+    ++seek;
+    if (m & finals) {
+      accepted = seek;
+      last = m;
+    }
+  }
+  // The state is left as if the characters read had been passed to
+  // update(), also when none of them matched.
+  active = a;
+  if (seek != begin) {
+    rule_ = m & finals? t.rule(m) : thread_flags::no_rule();
+  }
+  rule = last? t.rule(last) : thread_flags::no_rule();
+  return accepted;
+}
+
+}//namespace lex
+#endif// _bit_parallel_h_
@@ -0,0 +1,110 @@
+/*
+ * These functions are shared by the engines that simulate a program.
+ *
+ * A thread list is a sparse set of instruction pointers. add_closure()
+ * inserts a pc together with everything reachable from it through SPLIT and
+ * JUMP instructions. step() advances a whole list over one character.
+ * Both record what they saw in a thread_flags object.
+ */
+
+#ifndef _closure_h_
+#define _closure_h_
+
+#include "automaton/program.h"
+#include "data_structures/sparse_set.h"
+#include "regex_types.h"
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace lex {
+
+struct thread_flags {
+  static std::size_t no_rule() {
+    return std::numeric_limits<std::size_t>::max();
+  }
+
+  // A live list still holds a consuming instruction.
+  bool live {false};
+  // This is the smallest rule whose MATCH instruction was reached.
+  std::size_t rule {no_rule()};
+
+  bool matched() const {return rule != no_rule();}
+  void clear() {live = false; rule = no_rule();}
+  match_state state() const;
+};
+
+inline match_state thread_flags::state() const {
+  if (matched()) {
+    return live? match_state::MATCH : match_state::FINAL_MATCH;
+  }
+  return live? match_state::UNDECIDED : match_state::MISMATCH;
+}
+
+// The stack must have room for prog.size() + 1 entries. It never holds more
+// than that because a pc is only pushed when it is first added to the list.
+// The list must have the same capacity, since pc == prog.size() is the
+// position just past the end of a program without a final MATCH.
+template <typename CharT, typename Traits>
+void add_closure(const program<CharT, Traits>& prog,
+    sparse_set<std::size_t>& list, std::vector<std::size_t>& stack,
+    std::size_t pc, thread_flags& flags) {
+  std::size_t top {0};
+  if (list.insert(pc)) {
+    stack[top++] = pc;
+  }
+  while (top) {
+    pc = stack[--top];
+    if (pc == prog.size()) {
+      continue;
+    }
+    const auto& ins = prog[pc];
+    switch (ins.op) {
+    case opcode::CHAR:
+    case opcode::PRED:
+      flags.live = true;
+      break;
+    case opcode::MATCH:
+      if (ins.x < flags.rule) {
+        flags.rule = ins.x;
+      }
+      break;
+    case opcode::JUMP:
+      if (list.insert(ins.x)) {
+        stack[top++] = ins.x;
+      }
+      break;
+    case opcode::SPLIT:
+      if (list.insert(ins.y)) {
+        stack[top++] = ins.y;
+      }
+      if (list.insert(ins.x)) {
+        stack[top++] = ins.x;
+      }
+      break;
+    }
+  }
+}
+
+// Threads is any range of instruction pointers. The destination list is
+// cleared first.
+template <typename CharT, typename Traits, typename Threads>
+void step(const program<CharT, Traits>& prog, const Threads& from,
+    sparse_set<std::size_t>& to, std::vector<std::size_t>& stack,
+    CharT ch, thread_flags& flags) {
+  to.clear();
+  flags.clear();
+  for (auto pc : from) {
+    if (pc == prog.size()) {
+      continue;
+    }
+    const auto& ins = prog[pc];
+    if (ins.consumes() && prog.accepts(ins, ch)) {
+      add_closure(prog, to, stack, pc + 1, flags);
+    }
+  }
+}
+
+}//namespace lex
+#endif// _closure_h_
@@ -0,0 +1,507 @@
+/*
+ * A dfa is the complete deterministic automaton of a program over single
+ * byte characters. Unlike the lazy_dfa it is built all at once and never
+ * modified afterward. Its tables are plain arrays of 32 bit integers, so
+ * they can be saved to a file and used in place from a memory mapping (see
+ * dfa_file.h).
+ *
+ * Every byte is first mapped to a class, and each row of the transition
+ * table holds one entry per class. State 0 is always the dead state: it
+ * accepts nothing and all of its transitions lead back to itself.
+ *
+ * build_dfa() returns a minimal dfa. First every state from which no
+ * accepting state can be reached is merged into the dead state, so that
+ * scanning stops at the first character that rules out every match. Then
+ * equivalent states are merged by Hopcroft's algorithm. Two states are
+ * only equivalent if they accept the same rule, so rule priorities are
+ * kept.
+ *
+ * The tables are only read through a dfa_view, which does not own them.
+ * A dfa_engine is the run state for one pass through a dfa_view. It reports
+ * the same states as a lazy_dfa.
+ */
+
+#ifndef _dfa_h_
+#define _dfa_h_
+
+#include "automaton/closure.h"
+#include "automaton/program.h"
+#include "data_structures/optional.h"
+#include "data_structures/sparse_set.h"
+#include "regex_types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <vector>
+
+namespace lex {
+
+class dfa_view {
+ public:
+  using state_type = std::uint32_t;
+  using size_type = std::size_t;
+
+  static constexpr size_type alphabet_size = 256;
+  static state_type dead() {return 0;}
+  static std::uint32_t no_rule() {
+    return std::numeric_limits<std::uint32_t>::max();
+  }
+
+  dfa_view() = default;
+  dfa_view(const unsigned char* classes, const std::uint32_t* transitions,
+      const std::uint32_t* rules, const std::uint32_t* live,
+      size_type state_count, size_type class_count, state_type start)
+    : classes_ {classes},
+      transitions_ {transitions},
+      rules_ {rules},
+      live_ {live},
+      state_count_ {state_count},
+      class_count_ {class_count},
+      start_ {start} {}
+
+  size_type state_count() const {return state_count_;}
+  size_type class_count() const {return class_count_;}
+  state_type start() const {return start_;}
+
+  unsigned char byte_class(unsigned char byte) const {return classes_[byte];}
+  state_type next(state_type s, unsigned char byte) const {
+    return transitions_[s * class_count_ + classes_[byte]];
+  }
+  // This is the smallest rule accepted in state s, or no_rule().
+  std::uint32_t rule(state_type s) const {return rules_[s];}
+  // A live state has transitions to states other than the dead state.
+  bool live(state_type s) const {return live_[s] != 0;}
+
+  // These expose the raw tables for saving.
+  const unsigned char* class_table() const {return classes_;}
+  const std::uint32_t* transition_table() const {return transitions_;}
+  const std::uint32_t* rule_table() const {return rules_;}
+  const std::uint32_t* live_table() const {return live_;}
+ private:
+  const unsigned char* classes_ {nullptr};
+  const std::uint32_t* transitions_ {nullptr};
+  const std::uint32_t* rules_ {nullptr};
+  const std::uint32_t* live_ {nullptr};
+  size_type state_count_ {0};
+  size_type class_count_ {0};
+  state_type start_ {0};
+};
+
+class dfa;
+
+inline std::size_t default_dfa_state_limit() {return 1 << 16;}
+
+template <typename CharT, typename Traits>
+optional<dfa> build_dfa(const program<CharT, Traits>& prog,
+    std::size_t state_limit = default_dfa_state_limit());
+
+class dfa {
+ public:
+  using state_type = dfa_view::state_type;
+  using size_type = std::size_t;
+
+  // The default dfa has only the dead state, so it matches nothing.
+  dfa();
+
+  size_type state_count() const {return rules.size();}
+  // The view is invalidated when the dfa is modified or destroyed.
+  dfa_view view() const;
+
+  // This merges every state that cannot reach an accepting state into the
+  // dead state.
+  void prune();
+  // This prunes the dfa and then merges all equivalent states.
+  void minimize();
+
+  template <typename CharT, typename Traits>
+  friend optional<dfa> build_dfa(const program<CharT, Traits>& prog,
+      std::size_t state_limit);
+ private:
+  std::vector<unsigned char> classes;
+  std::vector<std::uint32_t> transitions;
+  std::vector<std::uint32_t> rules;
+  std::vector<std::uint32_t> live;
+  size_type class_count;
+  state_type start;
+
+  dfa(const std::vector<unsigned char>& class_map, size_type count);
+
+  state_type add_state(std::uint32_t rule, bool is_live);
+  // This renumbers the states. Old state s becomes block[s], and the
+  // blocks must respect transitions. Block 0 must hold the dead state.
+  void merge(const std::vector<state_type>& block, size_type count);
+  void update_live();
+};
+
+inline dfa::dfa()
+  : classes(dfa_view::alphabet_size),
+    class_count {dfa_view::alphabet_size},
+    start {dfa_view::dead()} {
+  for (size_type byte = 0; byte < classes.size(); ++byte) {
+    classes[byte] = static_cast<unsigned char>(byte);
+  }
+  add_state(dfa_view::no_rule(), false);
+}
+
+inline dfa::dfa(const std::vector<unsigned char>& class_map,
+    size_type count)
+  : classes(class_map),
+    class_count {count},
+    start {dfa_view::dead()} {
+  add_state(dfa_view::no_rule(), false);
+}
+
+inline dfa_view dfa::view() const {
+  return dfa_view(classes.data(), transitions.data(), rules.data(),
+      live.data(), state_count(), class_count, start);
+}
+
+// New states start out with every transition leading to the dead state.
+inline dfa::state_type dfa::add_state(std::uint32_t rule, bool is_live) {
+  rules.push_back(rule);
+  live.push_back(is_live);
+  transitions.resize(transitions.size() + class_count, dfa_view::dead());
+  return static_cast<state_type>(rules.size() - 1);
+}
+
+// A state only counts as live if some input leads out of the dead state.
+inline void dfa::update_live() {
+  for (size_type s = 0; s < state_count(); ++s) {
+    auto row = transitions.begin() + s * class_count;
+    live[s] = std::any_of(row, row + class_count,
+        [] (state_type t) {return t != dfa_view::dead();});
+  }
+}
+
+inline void dfa::merge(const std::vector<state_type>& block,
+    size_type count) {
+  std::vector<std::uint32_t> new_transitions(count * class_count);
+  std::vector<std::uint32_t> new_rules(count);
+  for (size_type s = 0; s < state_count(); ++s) {
+    auto b = block[s];
+    new_rules[b] = rules[s];
+    for (size_type c = 0; c < class_count; ++c) {
+      new_transitions[b * class_count + c] = 
+        block[transitions[s * class_count + c]];
+    }
+  }
+  transitions.swap(new_transitions);
+  rules.swap(new_rules);
+  live.assign(count, 0);
+  start = block[start];
+  update_live();
+}
+
+// The states that can reach an accepting state are found by searching
+// backward from the accepting states.
+inline void dfa::prune() {
+  auto n = state_count();
+  std::vector<std::vector<state_type>> sources(n);
+  for (size_type s = 0; s < n; ++s) {
+    for (size_type c = 0; c < class_count; ++c) {
+      sources[transitions[s * class_count + c]].push_back(s);
+    }
+  }
+
+  std::vector<bool> useful(n, false);
+  std::vector<state_type> stack;
+  for (size_type s = 0; s < n; ++s) {
+    if (rules[s] != dfa_view::no_rule()) {
+      useful[s] = true;
+      stack.push_back(s);
+    }
+  }
+  while (!stack.empty()) {
+    auto s = stack.back();
+    stack.pop_back();
+    for (auto source : sources[s]) {
+      if (!useful[source]) {
+        useful[source] = true;
+        stack.push_back(source);
+      }
+    }
+  }
+
+  std::vector<state_type> block(n, dfa_view::dead());
+  size_type count {1};
+  for (size_type s = 1; s < n; ++s) {
+    if (useful[s]) {
+      block[s] = static_cast<state_type>(count++);
+    }
+  }
+  merge(block, count);
+}
+
+// This is Hopcroft's algorithm. The partition is kept as a permutation of
+// the states in which every block is a contiguous range. Splitting a block
+// moves the states that lead into the splitter to the front of its range.
+// The initial partition groups states by the rule they accept.
+inline void dfa::minimize() {
+  prune();
+  auto n = state_count();
+  auto k = class_count;
+
+  // The sources of every transition, grouped by target and class.
+  std::vector<size_type> first_source(n * k + 1, 0);
+  for (size_type s = 0; s < n; ++s) {
+    for (size_type c = 0; c < k; ++c) {
+      ++first_source[transitions[s * k + c] * k + c + 1];
+    }
+  }
+  for (size_type i = 1; i < first_source.size(); ++i) {
+    first_source[i] += first_source[i - 1];
+  }
+  std::vector<state_type> sources(n * k);
+  {
+    auto fill = first_source;
+    for (size_type s = 0; s < n; ++s) {
+      for (size_type c = 0; c < k; ++c) {
+        sources[fill[transitions[s * k + c] * k + c]++] = s;
+      }
+    }
+  }
+
+  std::vector<state_type> order(n);
+  std::vector<size_type> position(n);
+  std::vector<size_type> block_of(n);
+  std::vector<size_type> begin;
+  std::vector<size_type> end;
+  std::vector<size_type> marked;
+  for (size_type s = 0; s < n; ++s) {
+    order[s] = static_cast<state_type>(s);
+  }
+  std::stable_sort(order.begin(), order.end(),
+      [this] (state_type a, state_type b) {return rules[a] < rules[b];});
+  for (size_type i = 0; i < n; ++i) {
+    position[order[i]] = i;
+    if (i == 0 || rules[order[i]] != rules[order[i - 1]]) {
+      begin.push_back(i);
+      end.push_back(i);
+      marked.push_back(0);
+    }
+    block_of[order[i]] = begin.size() - 1;
+    ++end.back();
+  }
+
+  std::vector<std::pair<size_type, size_type>> work;
+  std::vector<bool> waiting;
+  for (size_type b = 0; b < begin.size(); ++b) {
+    for (size_type c = 0; c < k; ++c) {
+      work.emplace_back(b, c);
+      waiting.push_back(true);
+    }
+  }
+
+  std::vector<state_type> splitter;
+  std::vector<size_type> touched;
+  while (!work.empty()) {
+    auto b = work.back().first;
+    auto c = work.back().second;
+    work.pop_back();
+    waiting[b * k + c] = false;
+
+    splitter.clear();
+    for (auto i = begin[b]; i != end[b]; ++i) {
+      auto target = order[i];
+      auto from = first_source.begin() + target * k + c;
+      splitter.insert(splitter.end(), sources.begin() + *from,
+          sources.begin() + *(from + 1));
+    }
+
+    touched.clear();
+    for (auto s : splitter) {
+      auto y = block_of[s];
+      auto front = begin[y] + marked[y];
+      if (position[s] < front) continue;
+      if (marked[y] == 0) {
+        touched.push_back(y);
+      }
+      auto other = order[front];
+      std::swap(order[front], order[position[s]]);
+      position[other] = position[s];
+      position[s] = front;
+      ++marked[y];
+    }
+
+    for (auto y : touched) {
+      auto count = marked[y];
+      marked[y] = 0;
+      if (count == end[y] - begin[y]) continue;
+
+      auto z = begin.size();
+      begin.push_back(begin[y]);
+      end.push_back(begin[y] + count);
+      marked.push_back(0);
+      begin[y] += count;
+      for (auto i = begin[z]; i != end[z]; ++i) {
+        block_of[order[i]] = z;
+      }
+
+      waiting.resize(waiting.size() + k, false);
+      auto smaller = (end[z] - begin[z] <= end[y] - begin[y])? z : y;
+      for (size_type a = 0; a < k; ++a) {
+        auto target = waiting[y * k + a]? z : smaller;
+        if (!waiting[target * k + a]) {
+          waiting[target * k + a] = true;
+          work.emplace_back(target, a);
+        }
+      }
+    }
+  }
+
+  // The block of the dead state becomes state 0.
+  auto dead_block = block_of[dfa_view::dead()];
+  std::vector<state_type> block(n);
+  for (size_type s = 0; s < n; ++s) {
+    auto b = block_of[s];
+    if (b == dead_block) {
+      b = 0;
+    } else if (b == 0) {
+      b = dead_block;
+    }
+    block[s] = static_cast<state_type>(b);
+  }
+  merge(block, begin.size());
+}
+
+// This is ordinary subset construction. States are identified exactly as
+// in the lazy_dfa: by their sorted consuming instructions together with
+// the rule they accept. If the dfa would need more than state_limit states
+// nothing is returned.
+template <typename CharT, typename Traits>
+optional<dfa> build_dfa(const program<CharT, Traits>& prog,
+    std::size_t state_limit) {
+  static_assert(sizeof(CharT) == 1, "A dfa needs single byte characters.");
+  using index_type = std::size_t;
+  using key_type = std::vector<index_type>;
+  using state_type = dfa::state_type;
+
+  dfa result(prog.class_map(), prog.class_count());
+  std::map<key_type, state_type> ids;
+  std::vector<key_type> threads(1);
+  ids.emplace(key_type{}, dfa_view::dead());
+
+  sparse_set<index_type> list(prog.size() + 1);
+  std::vector<index_type> stack(prog.size() + 1);
+  key_type key;
+  bool overflow {false};
+
+  auto add = [&] (thread_flags f) -> state_type {
+    key.clear();
+    for (auto pc : list) {
+      if (pc != prog.size() && prog[pc].consumes()) {
+        key.push_back(pc);
+      }
+    }
+    std::sort(key.begin(), key.end());
+    auto threads_size = key.size();
+    if (f.matched()) {
+      key.push_back(prog.size());
+      key.push_back(f.rule);
+    }
+    auto it = ids.find(key);
+    if (it != ids.end()) {
+      return it->second;
+    }
+    if (result.state_count() == state_limit) {
+      overflow = true;
+      return dfa_view::dead();
+    }
+    auto rule = f.matched()? static_cast<std::uint32_t>(f.rule) :
+                             dfa_view::no_rule();
+    auto id = result.add_state(rule, f.live);
+    ids.emplace(key, id);
+    threads.emplace_back(key.begin(), key.begin() + threads_size);
+    return id;
+  };
+
+  thread_flags f;
+  add_closure(prog, list, stack, 0, f);
+  result.start = add(f);
+
+  for (state_type s = 1; !overflow && s < result.state_count(); ++s) {
+    for (std::size_t c = 0; c < result.class_count; ++c) {
+      auto byte = prog.representative(c);
+      step(prog, threads[s], list, stack, static_cast<CharT>(byte), f);
+      auto target = add(f);
+      result.transitions[s * result.class_count + c] = target;
+    }
+  }
+  if (overflow) {
+    return {};
+  }
+
+  result.minimize();
+  return result;
+}
+
+class dfa_engine {
+ public:
+  using state_type = dfa_view::state_type;
+
+  // The tables viewed must outlive the engine.
+  explicit dfa_engine(dfa_view v)
+    : table {v},
+      current {v.start()} {}
+
+  match_state state() const;
+  // This is the smallest rule matched by the input so far.
+  std::size_t rule() const;
+
+  void update(unsigned char ch) {current = table.next(current, ch);}
+  void initialize() {current = table.start();}
+
+  // This returns the end of the longest match at the start of the range.
+  // If nothing matches, begin is returned. The second form also sets rule
+  // to the rule of that match, or to thread_flags::no_rule().
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end);
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end, std::size_t& rule);
+ private:
+  dfa_view table;
+  state_type current;
+};
+
+inline match_state dfa_engine::state() const {
+  bool matched {table.rule(current) != dfa_view::no_rule()};
+  bool live {table.live(current)};
+  if (matched) {
+    return live? match_state::MATCH : match_state::FINAL_MATCH;
+  }
+  return live? match_state::UNDECIDED : match_state::MISMATCH;
+}
+
+inline std::size_t dfa_engine::rule() const {
+  auto r = table.rule(current);
+  return r == dfa_view::no_rule()? thread_flags::no_rule() : r;
+}
+
+template <typename ForwardIt>
+ForwardIt dfa_engine::match(ForwardIt begin, ForwardIt end) {
+  std::size_t rule;
+  return match(begin, end, rule);
+}
+
+template <typename ForwardIt>
+ForwardIt dfa_engine::match(ForwardIt begin, ForwardIt end,
+    std::size_t& rule) {
+  initialize();
+  rule = thread_flags::no_rule();
+  auto accepted = begin;
+  for (auto seek = begin; table.live(current) && seek != end;) {
+    update(*seek);
+    ++seek;
+    if (table.rule(current) != dfa_view::no_rule()) {
+      accepted = seek;
+      rule = table.rule(current);
+    }
+  }
+  return accepted;
+}
+
+}//namespace lex
+#endif// _dfa_h_
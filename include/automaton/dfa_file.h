@@ -0,0 +1,353 @@
+/*
+ * The tables of a dfa can be saved to a file and mapped back into memory.
+ * A mapped file is used in place. Opening one reads its header and checks
+ * that every transition stays within the table; nothing is copied.
+ *
+ * The file layout is, in native byte order:
+ *   header        magic, format version, table sizes, start state, key
+ *   classes       256 bytes mapping each byte to its class
+ *   transitions   state_count * class_count 32 bit states
+ *   rules         state_count 32 bit rules
+ *   live          state_count 32 bit flags
+ * Each section is located from the sizes in the header alone, so a file
+ * holds no pointers and may be mapped at any address. A file written on a
+ * machine with a different byte order fails the version check.
+ *
+ * The key is chosen by the caller, usually as rule_set_hash() of the rules
+ * the dfa was built from. A dfa_cache keeps files named after their keys in
+ * a directory, so a process only needs to compile its rules the first time
+ * it sees them.
+ */
+
+#ifndef _dfa_file_h_
+#define _dfa_file_h_
+
+#include "automaton/dfa.h"
+#include "data_structures/optional.h"
+#include "regex_types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <locale>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lex {
+
+struct dfa_file_header {
+  static constexpr std::uint32_t current_version = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t state_count;
+  std::uint32_t class_count;
+  std::uint32_t start;
+  std::uint64_t key;
+};
+
+inline const char* dfa_file_magic() {return "lexdfa\r\n";}
+
+// 64 bit FNV-1a.
+inline std::uint64_t fnv1a(const void* data, std::size_t n,
+    std::uint64_t hash = 14695981039346656037ull) {
+  auto bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < n; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+// This hashes a range of rule patterns, each a basic_string, together with
+// the flags they are compiled with, the locale and the format version.
+// Every pattern is hashed with its length so that rule boundaries matter.
+// The tables depend on the locale only through its ctype facet, so the
+// locale is hashed as the class mask and both cases of every byte. Locales
+// that classify bytes alike therefore share their tables, even unnamed
+// ones.
+template <typename Iterator>
+std::uint64_t rule_set_hash(Iterator begin, Iterator end,
+    regex_constants::syntax_option_type flags,
+    const std::locale& loc = std::locale()) {
+  std::uint32_t head[] = {
+    dfa_file_header::current_version, static_cast<std::uint32_t>(flags)
+  };
+  auto hash = fnv1a(head, sizeof(head));
+
+  const auto& facet = std::use_facet<std::ctype<char>>(loc);
+  char bytes[dfa_view::alphabet_size];
+  for (std::size_t b = 0; b != dfa_view::alphabet_size; ++b) {
+    bytes[b] = static_cast<char>(b);
+  }
+  std::ctype_base::mask masks[dfa_view::alphabet_size];
+  facet.is(bytes, bytes + dfa_view::alphabet_size, masks);
+  hash = fnv1a(masks, sizeof(masks), hash);
+  char cases[dfa_view::alphabet_size];
+  std::copy(bytes, bytes + dfa_view::alphabet_size, cases);
+  facet.tolower(cases, cases + dfa_view::alphabet_size);
+  hash = fnv1a(cases, sizeof(cases), hash);
+  std::copy(bytes, bytes + dfa_view::alphabet_size, cases);
+  facet.toupper(cases, cases + dfa_view::alphabet_size);
+  hash = fnv1a(cases, sizeof(cases), hash);
+
+  for (auto it = begin; it != end; ++it) {
+    std::uint64_t length = it->size();
+    hash = fnv1a(&length, sizeof(length), hash);
+    hash = fnv1a(it->data(), length * sizeof((*it)[0]), hash);
+  }
+  return hash;
+}
+
+// The file is written under a temporary name and then renamed, so other
+// processes never map a partially written file. mkstemp() makes the name
+// unique to each call, so threads saving the same key do not write into
+// one temporary file.
+inline bool save_dfa(const dfa_view& table, const std::string& path,
+    std::uint64_t key) {
+  dfa_file_header header;
+  std::memcpy(header.magic, dfa_file_magic(), sizeof(header.magic));
+  header.version = dfa_file_header::current_version;
+  header.state_count = static_cast<std::uint32_t>(table.state_count());
+  header.class_count = static_cast<std::uint32_t>(table.class_count());
+  header.start = table.start();
+  header.key = key;
+
+  auto states = table.state_count();
+  std::string temp = path + ".tmpXXXXXX";
+  int fd = ::mkstemp(&temp[0]);
+  if (fd < 0) {
+    return false;
+  }
+  // mkstemp() leaves the file readable only by its owner.
+  ::fchmod(fd, 0644);
+  ::close(fd);
+  std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(table.class_table()),
+      dfa_view::alphabet_size);
+  out.write(reinterpret_cast<const char*>(table.transition_table()),
+      states * table.class_count() * sizeof(std::uint32_t));
+  out.write(reinterpret_cast<const char*>(table.rule_table()),
+      states * sizeof(std::uint32_t));
+  out.write(reinterpret_cast<const char*>(table.live_table()),
+      states * sizeof(std::uint32_t));
+  // Closing flushes the last block, which may fail too.
+  out.close();
+  if (!out) {
+    std::remove(temp.c_str());
+    return false;
+  }
+  if (std::rename(temp.c_str(), path.c_str()) != 0) {
+    std::remove(temp.c_str());
+    return false;
+  }
+  return true;
+}
+
+// A mapped_dfa owns a read only mapping of a saved dfa.
+class mapped_dfa {
+ public:
+  mapped_dfa() = default;
+  mapped_dfa(const mapped_dfa&) = delete;
+  mapped_dfa& operator=(const mapped_dfa&) = delete;
+  mapped_dfa(mapped_dfa&& other) {*this = std::move(other);}
+  mapped_dfa& operator=(mapped_dfa&& other);
+  ~mapped_dfa() {close();}
+
+  // This fails if the file is missing or malformed or if it was saved with
+  // a different key. On failure the mapped_dfa is left closed.
+  bool open(const std::string& path, std::uint64_t key);
+  void close();
+
+  bool is_open() const {return address != nullptr;}
+  // The view is invalidated when the mapped_dfa is closed.
+  dfa_view view() const {return table;}
+ private:
+  void* address {nullptr};
+  std::size_t length {0};
+  dfa_view table;
+
+  bool validate(std::uint64_t key);
+};
+
+inline mapped_dfa& mapped_dfa::operator=(mapped_dfa&& other) {
+  if (this != &other) {
+    close();
+    std::swap(address, other.address);
+    std::swap(length, other.length);
+    std::swap(table, other.table);
+  }
+  return *this;
+}
+
+inline bool mapped_dfa::open(const std::string& path, std::uint64_t key) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0 ||
+      static_cast<std::size_t>(info.st_size) < sizeof(dfa_file_header)) {
+    ::close(fd);
+    return false;
+  }
+  length = info.st_size;
+  void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) {
+    length = 0;
+    return false;
+  }
+  address = p;
+  if (!validate(key)) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+inline void mapped_dfa::close() {
+  if (address) {
+    ::munmap(address, length);
+  }
+  address = nullptr;
+  length = 0;
+  table = dfa_view();
+}
+
+inline bool mapped_dfa::validate(std::uint64_t key) {
+  dfa_file_header header;
+  std::memcpy(&header, address, sizeof(header));
+  if (std::memcmp(header.magic, dfa_file_magic(), sizeof(header.magic)) ||
+      header.version != dfa_file_header::current_version ||
+      header.key != key || header.state_count == 0 ||
+      header.class_count == 0 ||
+      header.class_count > dfa_view::alphabet_size ||
+      header.start >= header.state_count) {
+    return false;
+  }
+
+  std::size_t states = header.state_count;
+  std::size_t cells = states * header.class_count;
+  std::size_t expected = sizeof(header) + dfa_view::alphabet_size +
+    (cells + 2 * states) * sizeof(std::uint32_t);
+  if (length != expected) {
+    return false;
+  }
+
+  auto base = static_cast<const unsigned char*>(address);
+  auto classes = base + sizeof(header);
+  auto transitions = reinterpret_cast<const std::uint32_t*>(
+      classes + dfa_view::alphabet_size);
+  auto rules = transitions + cells;
+  auto live = rules + states;
+
+  for (std::size_t byte = 0; byte < dfa_view::alphabet_size; ++byte) {
+    if (classes[byte] >= header.class_count) return false;
+  }
+  for (std::size_t cell = 0; cell < cells; ++cell) {
+    if (transitions[cell] >= states) return false;
+  }
+  table = dfa_view(classes, transitions, rules, live, states,
+      header.class_count, header.start);
+  return true;
+}
+
+// A cached_dfa holds what a dfa_cache found for a key: the mapping of its
+// file or, if the file could not be saved, the dfa that was built instead.
+class cached_dfa {
+ public:
+  bool is_open() const {return mapped.is_open() || built;}
+  bool is_mapped() const {return mapped.is_open();}
+  // The view is invalidated when the cached_dfa is loaded again or
+  // destroyed.
+  dfa_view view() const;
+ private:
+  mapped_dfa mapped;
+  optional<dfa> built;
+
+  friend class dfa_cache;
+};
+
+inline dfa_view cached_dfa::view() const {
+  if (mapped.is_open()) {
+    return mapped.view();
+  }
+  return built? built->view() : dfa_view();
+}
+
+// A dfa_cache maps keys to files in one directory, which must exist.
+class dfa_cache {
+ public:
+  explicit dfa_cache(std::string dir)
+    : directory {std::move(dir)} {}
+
+  std::string path(std::uint64_t key) const;
+
+  // This maps the dfa saved under key. If there is none, build() is called
+  // and its result is saved first. Build must return an optional<dfa>.
+  // This returns false if the dfa can neither be loaded nor built and
+  // saved.
+  template <typename Build>
+  bool load(std::uint64_t key, mapped_dfa& out, Build build) const;
+  // Saving is only an optimization here. If the built dfa cannot be saved,
+  // for instance because the directory is read only, out keeps it in
+  // memory. This returns false only if the dfa can neither be loaded nor
+  // built.
+  template <typename Build>
+  bool load(std::uint64_t key, cached_dfa& out, Build build) const;
+ private:
+  std::string directory;
+};
+
+inline std::string dfa_cache::path(std::uint64_t key) const {
+  char name[24];
+  std::snprintf(name, sizeof(name), "%016llx.dfa",
+      static_cast<unsigned long long>(key));
+  return directory + "/" + name;
+}
+
+template <typename Build>
+bool dfa_cache::load(std::uint64_t key, mapped_dfa& out, Build build) const {
+  auto file = path(key);
+  if (out.open(file, key)) {
+    return true;
+  }
+  auto table = build();
+  if (!table || !save_dfa(table->view(), file, key)) {
+    return false;
+  }
+  return out.open(file, key);
+}
+
+template <typename Build>
+bool dfa_cache::load(std::uint64_t key, cached_dfa& out, Build build) const {
+  out.built = optional<dfa>();
+  auto file = path(key);
+  if (out.mapped.open(file, key)) {
+    return true;
+  }
+  auto table = build();
+  if (!table) {
+    return false;
+  }
+  if (save_dfa(table->view(), file, key) && out.mapped.open(file, key)) {
+    return true;
+  }
+  out.built = std::move(table);
+  return true;
+}
+
+}//namespace lex
+#endif// _dfa_file_h_
@@ -0,0 +1,400 @@
+/*
+ * The lazy_dfa runs a program by subset construction done on demand. Each
+ * DFA state is the set of consuming instructions that are live after some
+ * input. States and transitions are only computed when the input first
+ * needs them and then cached, so an input that stays within a handful of
+ * states costs one table lookup per character.
+ *
+ * The cache holds at most state_limit states. When it is full it is
+ * flushed and rebuilt from the current state. If the cache keeps filling up
+ * after only a few characters, as it does for patterns whose DFA is
+ * exponentially large, the lazy_dfa gives up on caching and simulates the
+ * NFA directly, just like the pike_vm.
+ *
+ * Each row of the transition table has one entry per byte class of the
+ * program rather than one per byte, so only single byte character types are
+ * cached. Wider character types always use the NFA simulation.
+ *
+ * The states reported have the same meaning as those of a pike_vm.
+ *
+ * match() over contiguous single byte input runs a tight loop over
+ * pointers that only reads the cached table. It leaves the loop only to
+ * compute a missing transition.
+ */
+
+#ifndef _lazy_dfa_h_
+#define _lazy_dfa_h_
+
+#include "automaton/closure.h"
+#include "automaton/program.h"
+#include "data_structures/contiguous_iterator.h"
+#include "data_structures/sparse_set.h"
+#include "regex_types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lex {
+
+template <typename CharT, typename Traits>
+class lazy_dfa {
+ public:
+  using value_type = CharT;
+  using traits_type = Traits;
+  using program_type = program<CharT, Traits>;
+  using program_pointer = std::shared_ptr<const program_type>;
+  using index_type = std::size_t;
+  using size_type = std::size_t;
+
+  static size_type default_state_limit() {return 1024;}
+
+  explicit lazy_dfa(program_pointer p,
+      size_type state_limit = default_state_limit());
+
+  match_state state() const {return flags_.state();}
+  // This is the smallest rule matched by the input so far.
+  index_type rule() const {return flags_.rule;}
+
+  // This advances the automaton over ch.
+  void update(value_type ch);
+  // This returns the automaton to its start state. Cached states are kept.
+  void initialize();
+
+  // This returns the end of the longest match at the start of the range.
+  // If nothing matches, begin is returned. The second form also sets rule
+  // to the rule of that match, or to thread_flags::no_rule().
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end);
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end, index_type& rule);
+
+  // These describe the cache. They are mostly useful for testing.
+  bool using_nfa() const {return nfa_mode;}
+  size_type state_count() const {return states.size();}
+  size_type flush_count() const {return flushes;}
+ private:
+  using state_id = int;
+  using key_type = std::vector<index_type>;
+
+  struct dfa_state {
+    thread_flags flags;
+    std::vector<index_type> threads;
+  };
+
+  static constexpr bool cacheable = sizeof(CharT) == 1;
+  static constexpr state_id unknown = -1;
+  // A flush after fewer than this many characters per cached state counts
+  // as thrashing. Three thrashing flushes in a row switch to the NFA.
+  static constexpr size_type min_chars_per_state = 10;
+  static constexpr size_type max_thrashing = 3;
+
+  program_pointer prog;
+  size_type limit;
+  // This is the length of a row of the transition table.
+  size_type width;
+
+  std::vector<dfa_state> states;
+  std::vector<state_id> transitions;
+  std::map<key_type, state_id> cache;
+  state_id start {unknown};
+  state_id current {unknown};
+
+  bool nfa_mode;
+  size_type flushes {0};
+  size_type thrashing {0};
+  size_type chars_since_flush {0};
+
+  // This is scratch space for building states and for the NFA simulation.
+  sparse_set<index_type> threads;
+  sparse_set<index_type> next;
+  std::vector<index_type> stack;
+  key_type key;
+  thread_flags flags_;
+
+  size_type column(value_type ch) const {
+    return prog->byte_class(static_cast<unsigned char>(ch));
+  }
+
+  void dfa_update(value_type ch);
+  void nfa_update(value_type ch);
+  state_id transition(value_type ch);
+  state_id add_state(const sparse_set<index_type>& list, thread_flags f);
+  void flush();
+  void switch_to_nfa();
+
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end, index_type& rule,
+      std::false_type);
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end, index_type& rule,
+      std::true_type);
+  const CharT* match_cached(const CharT* begin, const CharT* end,
+      index_type& rule);
+};
+
+template <typename CharT, typename Traits>
+lazy_dfa<CharT, Traits>::lazy_dfa(program_pointer p, size_type state_limit)
+  : prog {std::move(p)},
+    limit {std::max<size_type>(state_limit, 2)},
+    width {prog->class_count()},
+    nfa_mode {!cacheable},
+    threads(prog->size() + 1),
+    next(prog->size() + 1),
+    stack(prog->size() + 1) {
+  initialize();
+}
+
+template <typename CharT, typename Traits>
+constexpr typename lazy_dfa<CharT, Traits>::state_id 
+lazy_dfa<CharT, Traits>::unknown;
+
+template <typename CharT, typename Traits>
+void lazy_dfa<CharT, Traits>::initialize() {
+  // Adding the start state may itself switch to the NFA.
+  if (!nfa_mode && start == unknown) {
+    next.clear();
+    thread_flags f;
+    add_closure(*prog, next, stack, 0, f);
+    start = add_state(next, f);
+  }
+  if (nfa_mode) {
+    threads.clear();
+    flags_.clear();
+    add_closure(*prog, threads, stack, 0, flags_);
+    return;
+  }
+  current = start;
+  flags_ = states[current].flags;
+}
+
+template <typename CharT, typename Traits>
+void lazy_dfa<CharT, Traits>::update(value_type ch) {
+  if (state() == match_state::MISMATCH) {
+    return;
+  }
+  if (nfa_mode) {
+    nfa_update(ch);
+  } else {
+    dfa_update(ch);
+  }
+}
+
+template <typename CharT, typename Traits>
+void lazy_dfa<CharT, Traits>::dfa_update(value_type ch) {
+  ++chars_since_flush;
+  auto target = transitions[current * width + column(ch)];
+  if (target == unknown) {
+    target = transition(ch);
+    if (nfa_mode) return;
+  }
+  current = target;
+  flags_ = states[current].flags;
+}
+
+template <typename CharT, typename Traits>
+void lazy_dfa<CharT, Traits>::nfa_update(value_type ch) {
+  step(*prog, threads, next, stack, ch, flags_);
+  threads.swap(next);
+}
+
+// This computes the transition out of the current state. The result is
+// built in next before the cache is consulted, so it survives a flush.
+template <typename CharT, typename Traits>
+typename lazy_dfa<CharT, Traits>::state_id
+lazy_dfa<CharT, Traits>::transition(value_type ch) {
+  thread_flags f;
+  step(*prog, states[current].threads, next, stack, ch, f);
+
+  auto source = current;
+  auto before = flushes;
+  auto target = add_state(next, f);
+  if (nfa_mode) {
+    return unknown;
+  }
+  if (flushes == before) {
+    transitions[source * width + column(ch)] = target;
+  }
+  return target;
+}
+
+// The key of a state is its sorted list of consuming instructions,
+// followed by the program size and the matched rule if it accepts.
+template <typename CharT, typename Traits>
+typename lazy_dfa<CharT, Traits>::state_id
+lazy_dfa<CharT, Traits>::add_state(const sparse_set<index_type>& list,
+    thread_flags f) {
+  key.clear();
+  for (auto pc : list) {
+    if (pc != prog->size() && (*prog)[pc].consumes()) {
+      key.push_back(pc);
+    }
+  }
+  std::sort(key.begin(), key.end());
+  if (f.matched()) {
+    key.push_back(prog->size());
+    key.push_back(f.rule);
+  }
+
+  auto it = cache.find(key);
+  if (it != cache.end()) {
+    return it->second;
+  }
+
+  if (states.size() == limit) {
+    flush();
+    if (nfa_mode) {
+      threads.clear();
+      for (auto pc : list) {
+        threads.insert(pc);
+      }
+      flags_ = f;
+      return unknown;
+    }
+  }
+
+  dfa_state s;
+  s.flags = f;
+  s.threads.assign(key.begin(), key.end() - (f.matched()? 2 : 0));
+  states.push_back(std::move(s));
+  transitions.resize(states.size() * width, unknown);
+
+  auto id = static_cast<state_id>(states.size() - 1);
+  cache.emplace(key, id);
+  return id;
+}
+
+template <typename CharT, typename Traits>
+void lazy_dfa<CharT, Traits>::flush() {
+  ++flushes;
+  if (chars_since_flush < limit * min_chars_per_state) {
+    ++thrashing;
+  } else {
+    thrashing = 0;
+  }
+  chars_since_flush = 0;
+
+  states.clear();
+  transitions.clear();
+  cache.clear();
+  start = unknown;
+  current = unknown;
+
+  if (thrashing >= max_thrashing) {
+    switch_to_nfa();
+  }
+}
+
+template <typename CharT, typename Traits>
+void lazy_dfa<CharT, Traits>::switch_to_nfa() {
+  nfa_mode = true;
+  states.shrink_to_fit();
+  transitions.shrink_to_fit();
+}
+
+template <typename CharT, typename Traits>
+template <typename ForwardIt>
+ForwardIt lazy_dfa<CharT, Traits>::match(ForwardIt begin, ForwardIt end) {
+  index_type rule;
+  return match(begin, end, rule);
+}
+
+template <typename CharT, typename Traits>
+template <typename ForwardIt>
+ForwardIt lazy_dfa<CharT, Traits>::match(ForwardIt begin, ForwardIt end,
+    index_type& rule) {
+  return match(begin, end, rule, std::integral_constant<bool,
+      cacheable && is_contiguous_iterator<ForwardIt>::value>{});
+}
+
+template <typename CharT, typename Traits>
+template <typename ForwardIt>
+ForwardIt lazy_dfa<CharT, Traits>::match(ForwardIt begin, ForwardIt end,
+    index_type& rule, std::false_type) {
+  initialize();
+  rule = thread_flags::no_rule();
+  auto accepted = begin;
+  for (auto seek = begin; flags_.live && seek != end;) {
+    update(*seek);
+    ++seek;
+    if (flags_.matched()) {
+      accepted = seek;
+      rule = flags_.rule;
+    }
+  }
+  return accepted;
+}
+
+template <typename CharT, typename Traits>
+template <typename ForwardIt>
+ForwardIt lazy_dfa<CharT, Traits>::match(ForwardIt begin, ForwardIt end,
+    index_type& rule, std::true_type) {
+  if (begin == end) {
+    initialize();
+    rule = thread_flags::no_rule();
+    return begin;
+  }
+  const CharT* first = to_pointer(begin);
+  auto last = first + std::distance(begin, end);
+  return std::next(begin, match_cached(first, last, rule) - first);
+}
+
+// The inner loop keeps the state in a local and reads the table directly.
+// It stops at a missing transition, which dfa_update() then computes and
+// caches. If that switches to the NFA, the rest is matched generically.
+template <typename CharT, typename Traits>
+const CharT* lazy_dfa<CharT, Traits>::match_cached(const CharT* begin,
+    const CharT* end, index_type& rule) {
+  initialize();
+  rule = thread_flags::no_rule();
+  auto accepted = begin;
+  auto seek = begin;
+  while (!nfa_mode && flags_.live && seek != end) {
+    const auto* classes = prog->class_map().data();
+    const auto* table = transitions.data();
+    auto run_start = seek;
+    auto s = current;
+    for (; seek != end; ++seek) {
+      auto target = 
+        table[s * width + classes[static_cast<unsigned char>(*seek)]];
+      if (target == unknown) break;
+      s = target;
+      const auto& f = states[s].flags;
+      if (f.matched()) {
+        accepted = seek + 1;
+        rule = f.rule;
+      }
+      if (!f.live) {
+        ++seek;
+        break;
+      }
+    }
+    chars_since_flush += seek - run_start;
+    current = s;
+    flags_ = states[s].flags;
+    if (seek == end || !flags_.live) break;
+
+    dfa_update(*seek);
+    ++seek;
+    if (flags_.matched()) {
+      accepted = seek;
+      rule = flags_.rule;
+    }
+  }
+  for (; nfa_mode && flags_.live && seek != end;) {
+    nfa_update(*seek);
+    ++seek;
+    if (flags_.matched()) {
+      accepted = seek;
+      rule = flags_.rule;
+    }
+  }
+  return accepted;
+}
+
+}//namespace lex
+#endif// _lazy_dfa_h_
@@ -0,0 +1,181 @@
+/*
+ * Every match of some programs must start with the same string of
+ * characters, such as "<!--" or "ERROR ". literal_prefix() finds that
+ * string, and find_literal() finds its next occurrence in the input, so a
+ * search only needs to start the automaton at candidate positions.
+ *
+ * On contiguous single byte input find_literal() compares a whole block of
+ * positions at once. A position is a candidate if both the first and the
+ * last character of the literal are in place, and only candidates are
+ * compared in full. Blocks are 32 bytes wide when the compiler targets
+ * AVX2 and 16 bytes wide with SSE2. Without either, memchr() finds the
+ * first character. Any other input is searched with std::search().
+ */
+
+#ifndef _literal_search_h_
+#define _literal_search_h_
+
+#include "automaton/closure.h"
+#include "automaton/program.h"
+#include "data_structures/contiguous_iterator.h"
+#include "data_structures/sparse_set.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace lex {
+
+// The prefix is extended one character at a time for as long as every
+// live thread needs the same character and none of them has matched.
+template <typename CharT, typename Traits>
+std::basic_string<CharT> literal_prefix(const program<CharT, Traits>& prog,
+    std::size_t max_length = 256) {
+  std::basic_string<CharT> prefix;
+  sparse_set<std::size_t> threads(prog.size() + 1);
+  sparse_set<std::size_t> next(prog.size() + 1);
+  std::vector<std::size_t> stack(prog.size() + 1);
+  thread_flags flags;
+  add_closure(prog, threads, stack, 0, flags);
+
+  while (prefix.size() < max_length && !flags.matched() && flags.live) {
+    bool first {true};
+    CharT ch {};
+    for (auto pc : threads) {
+      if (pc == prog.size() || !prog[pc].consumes()) continue;
+      if (prog[pc].op != opcode::CHAR || (!first && prog[pc].ch != ch)) {
+        return prefix;
+      }
+      ch = prog[pc].ch;
+      first = false;
+    }
+    prefix.push_back(ch);
+    step(prog, threads, next, stack, ch, flags);
+    threads.swap(next);
+  }
+  return prefix;
+}
+
+namespace detail {
+
+// The bits of mask are candidate offsets from p.
+inline const char* verify_candidates(unsigned mask, const char* p,
+    const char* literal, std::size_t n) {
+  while (mask) {
+#if defined(__GNUC__)
+    auto offset = __builtin_ctz(mask);
+#else
+    unsigned offset {0};
+    while (!((mask >> offset) & 1)) ++offset;
+#endif
+    if (std::memcmp(p + offset + 1, literal + 1, n - 1) == 0) {
+      return p + offset;
+    }
+    mask &= mask - 1;
+  }
+  return nullptr;
+}
+
+// This returns the first start of the literal in [begin, last] that it
+// finds in whole blocks, and leaves begin at the first position that it
+// did not examine.
+inline const char* find_literal_blocks(const char*& begin, const char* last,
+    const char* literal, std::size_t n) {
+#if defined(__AVX2__)
+  const auto first_byte = _mm256_set1_epi8(literal[0]);
+  const auto last_byte = _mm256_set1_epi8(literal[n - 1]);
+  for (; last - begin >= 31; begin += 32) {
+    auto front = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(begin));
+    auto back = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(begin + n - 1));
+    auto mask = static_cast<unsigned>(_mm256_movemask_epi8(
+          _mm256_and_si256(_mm256_cmpeq_epi8(front, first_byte),
+            _mm256_cmpeq_epi8(back, last_byte))));
+    if (auto found = verify_candidates(mask, begin, literal, n)) {
+      return found;
+    }
+  }
+#elif defined(__SSE2__)
+  const auto first_byte = _mm_set1_epi8(literal[0]);
+  const auto last_byte = _mm_set1_epi8(literal[n - 1]);
+  for (; last - begin >= 15; begin += 16) {
+    auto front = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    auto back = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(begin + n - 1));
+    auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+          _mm_and_si128(_mm_cmpeq_epi8(front, first_byte),
+            _mm_cmpeq_epi8(back, last_byte))));
+    if (auto found = verify_candidates(mask, begin, literal, n)) {
+      return found;
+    }
+  }
+#endif
+  return nullptr;
+}
+
+}//namespace detail
+
+// This returns the start of the first occurrence of the literal in
+// [begin, end), or end if there is none. An empty literal is found at
+// begin.
+inline const char* find_literal(const char* begin, const char* end,
+    const char* literal, std::size_t n) {
+  if (n == 0) return begin;
+  if (static_cast<std::size_t>(end - begin) < n) return end;
+  // The last position at which the literal could start.
+  const char* last = end - n;
+  if (auto found = detail::find_literal_blocks(begin, last, literal, n)) {
+    return found;
+  }
+  while (begin <= last) {
+    auto p = static_cast<const char*>(
+        std::memchr(begin, literal[0], last - begin + 1));
+    if (!p) break;
+    if (std::memcmp(p + 1, literal + 1, n - 1) == 0) return p;
+    begin = p + 1;
+  }
+  return end;
+}
+
+namespace detail {
+
+template <typename ForwardIt, typename CharT>
+ForwardIt find_literal_in(ForwardIt begin, ForwardIt end,
+    const std::basic_string<CharT>& literal, std::false_type) {
+  return std::search(begin, end, literal.begin(), literal.end());
+}
+
+template <typename ForwardIt, typename CharT>
+ForwardIt find_literal_in(ForwardIt begin, ForwardIt end,
+    const std::basic_string<CharT>& literal, std::true_type) {
+  if (begin == end) return end;
+  auto first = reinterpret_cast<const char*>(to_pointer(begin));
+  auto last = first + std::distance(begin, end);
+  auto found = find_literal(first, last,
+      reinterpret_cast<const char*>(literal.data()), literal.size());
+  return std::next(begin, found - first);
+}
+
+}//namespace detail
+
+// The input may be any forward range.
+template <typename ForwardIt, typename CharT>
+ForwardIt find_literal(ForwardIt begin, ForwardIt end,
+    const std::basic_string<CharT>& literal) {
+  using value_type = typename std::iterator_traits<ForwardIt>::value_type;
+  return detail::find_literal_in(begin, end, literal,
+      std::integral_constant<bool, is_contiguous_iterator<ForwardIt>::value &&
+        sizeof(value_type) == 1 && sizeof(CharT) == 1>{});
+}
+
+}//namespace lex
+#endif// _literal_search_h_
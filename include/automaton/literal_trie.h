@@ -0,0 +1,384 @@
+/*
+ * Many lexer rules are plain keywords or punctuation, and some patterns are
+ * only alternations of such literals, e.g. "SELECT|FROM|WHERE".
+ * literal_alternatives() recognizes those programs and lists the strings
+ * they match. A literal_trie holds the strings of any number of rules, and
+ * a literal_trie_engine runs it with the same interface as the other
+ * engines.
+ *
+ * A lexer only matches at the start of its input, so the trie needs no
+ * Aho-Corasick failure links: every character follows a single edge or
+ * ends the match. The edges of each node are stored sorted in one flat
+ * array and found by binary search, so the cost of a character does not
+ * depend on the number of strings in the trie.
+ *
+ * Each node accepts the smallest rule that ends there, so rule priorities
+ * are kept. Empty strings are dropped, since an empty match is never
+ * accepted.
+ *
+ * Keywords of icase rules are listed by folded_alternatives() in lower
+ * case. The trie gives each of their characters an edge for both cases,
+ * so they cost no more per character than exact keywords.
+ */
+
+#ifndef _literal_trie_h_
+#define _literal_trie_h_
+
+#include "automaton/closure.h"
+#include "automaton/program.h"
+#include "data_structures/optional.h"
+#include "regex_types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <locale>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lex {
+
+namespace detail {
+
+template <typename CharT, typename Traits>
+optional<std::vector<std::basic_string<CharT>>>
+alternatives(const program<CharT, Traits>& prog, bool folded,
+    std::size_t max_count, std::size_t max_steps) {
+  using string_type = std::basic_string<CharT>;
+  struct path {
+    std::size_t pc;
+    string_type text;
+    // The instructions followed so far. A path longer than the program
+    // must have gone around a loop.
+    std::size_t length;
+  };
+
+  std::vector<string_type> words;
+  std::vector<path> stack {path {0, string_type {}, 0}};
+  std::size_t steps {0};
+  while (!stack.empty()) {
+    auto current = std::move(stack.back());
+    stack.pop_back();
+    if (++steps > max_steps || current.pc >= prog.size() ||
+        current.length > prog.size()) {
+      return {};
+    }
+    const auto& ins = prog[current.pc];
+    ++current.length;
+    switch (ins.op) {
+    case opcode::CHAR:
+    case opcode::PRED:
+      // A folded predicate stands for its lower case.
+      if (ins.op == opcode::PRED && (!folded || ins.ch == CharT('\0'))) {
+        return {};
+      }
+      current.text.push_back(ins.ch);
+      ++current.pc;
+      stack.push_back(std::move(current));
+      break;
+    case opcode::SPLIT:
+      stack.push_back(path {ins.y, current.text, current.length});
+      current.pc = ins.x;
+      stack.push_back(std::move(current));
+      break;
+    case opcode::JUMP:
+      current.pc = ins.x;
+      stack.push_back(std::move(current));
+      break;
+    case opcode::MATCH:
+      if (words.size() == max_count) {
+        return {};
+      }
+      words.push_back(std::move(current.text));
+      break;
+    }
+  }
+  return words;
+}
+
+// A trie of maps, the form in which the strings of a literal_trie are
+// first collected.
+template <typename CharT>
+struct map_trie {
+  using node_type = std::uint32_t;
+
+  std::vector<std::map<CharT, node_type>> children =
+    std::vector<std::map<CharT, node_type>>(1);
+  std::vector<std::size_t> rules =
+    std::vector<std::size_t>(1, thread_flags::no_rule());
+
+  // Iterator::value_type must be a pair of a string and its rule. This
+  // returns the number of strings inserted.
+  template <typename Iterator>
+  std::size_t insert(Iterator begin, Iterator end);
+};
+
+template <typename CharT>
+template <typename Iterator>
+std::size_t map_trie<CharT>::insert(Iterator begin, Iterator end) {
+  std::size_t count {0};
+  for (auto it = begin; it != end; ++it) {
+    const auto& word = it->first;
+    if (word.empty()) continue;
+    node_type node {0};
+    for (auto ch : word) {
+      auto found = children[node].find(ch);
+      if (found == children[node].end()) {
+        found = children[node].emplace(ch, children.size()).first;
+        children.emplace_back();
+        rules.push_back(thread_flags::no_rule());
+      }
+      node = found->second;
+    }
+    rules[node] = std::min<std::size_t>(rules[node], it->second);
+    ++count;
+  }
+  return count;
+}
+
+}//namespace detail
+
+// This returns every string the program matches, or nothing if the program
+// has a PRED instruction or a loop, matches more than max_count strings, or
+// would take more than max_steps instructions to enumerate.
+template <typename CharT, typename Traits>
+optional<std::vector<std::basic_string<CharT>>>
+literal_alternatives(const program<CharT, Traits>& prog,
+    std::size_t max_count = 1024, std::size_t max_steps = 1 << 16) {
+  return detail::alternatives(prog, false, max_count, max_steps);
+}
+
+// This is literal_alternatives() for a program compiled under icase, whose
+// folded PRED instructions are read as their lower case. Each string
+// stands for every one of its cases.
+template <typename CharT, typename Traits>
+optional<std::vector<std::basic_string<CharT>>>
+folded_alternatives(const program<CharT, Traits>& prog,
+    std::size_t max_count = 1024, std::size_t max_steps = 1 << 16) {
+  return detail::alternatives(prog, true, max_count, max_steps);
+}
+
+template <typename CharT>
+class literal_trie {
+ public:
+  using value_type = CharT;
+  using string_type = std::basic_string<CharT>;
+  using size_type = std::size_t;
+  using node_type = std::uint32_t;
+
+  static node_type root() {return 0;}
+  static node_type dead() {return std::numeric_limits<node_type>::max();}
+
+  // This is a trie of no strings.
+  literal_trie()
+    : first_edge(2, 0),
+      rules(1, thread_flags::no_rule()) {}
+
+  // Iterator::value_type must be a pair of a string_type and its rule.
+  template <typename Iterator>
+  literal_trie(Iterator begin, Iterator end);
+  // The strings from folded_begin to folded_end are in lower case, as
+  // folded_alternatives() lists them, and match in any case. The facet
+  // gives the upper case of each character.
+  template <typename Iterator, typename FoldedIterator>
+  literal_trie(Iterator begin, Iterator end, FoldedIterator folded_begin,
+      FoldedIterator folded_end, const std::ctype<value_type>& facet);
+
+  bool empty() const {return labels.empty();}
+  size_type node_count() const {return rules.size();}
+  size_type string_count() const {return strings;}
+
+  // The child of node along ch, or dead().
+  node_type next(node_type node, value_type ch) const;
+  // The smallest rule ending at node, or thread_flags::no_rule().
+  size_type rule(node_type node) const {return rules[node];}
+  bool has_children(node_type node) const {
+    return first_edge[node] != first_edge[node + 1];
+  }
+ private:
+  // The edges of node n are [first_edge[n], first_edge[n + 1]), sorted by
+  // label.
+  std::vector<size_type> first_edge;
+  std::vector<value_type> labels;
+  std::vector<node_type> targets;
+  std::vector<size_type> rules;
+  size_type strings {0};
+
+  void lay_out(const detail::map_trie<value_type>& exact,
+      const detail::map_trie<value_type>& folded,
+      const std::ctype<value_type>* facet);
+};
+
+// The strings are first inserted into tries of maps, which are then laid
+// out breadth first, so the edges of each node are contiguous and sorted.
+template <typename CharT>
+template <typename Iterator>
+literal_trie<CharT>::literal_trie(Iterator begin, Iterator end) {
+  detail::map_trie<value_type> exact;
+  strings = exact.insert(begin, end);
+  lay_out(exact, detail::map_trie<value_type> {}, nullptr);
+}
+
+template <typename CharT>
+template <typename Iterator, typename FoldedIterator>
+literal_trie<CharT>::literal_trie(Iterator begin, Iterator end,
+    FoldedIterator folded_begin, FoldedIterator folded_end,
+    const std::ctype<value_type>& facet) {
+  detail::map_trie<value_type> exact;
+  detail::map_trie<value_type> folded;
+  strings = exact.insert(begin, end) + folded.insert(folded_begin,
+      folded_end);
+  lay_out(exact, folded, &facet);
+}
+
+// Each node of the laid out trie is a pair of a node of the exact trie and
+// a node of the folded trie, either of which may be dead. An edge of the
+// folded trie is followed by both cases of its label. Only pairs that some
+// input reaches are made. A pair with a live exact node is reached by one
+// string only, so there are no more nodes than in the two tries together.
+template <typename CharT>
+void literal_trie<CharT>::lay_out(const detail::map_trie<value_type>& exact,
+    const detail::map_trie<value_type>& folded,
+    const std::ctype<value_type>* facet) {
+  using pair_type = std::pair<node_type, node_type>;
+  std::vector<pair_type> order {pair_type(root(), root())};
+  std::map<pair_type, node_type> numbers {{order.front(), root()}};
+  for (size_type i = 0; i != order.size(); ++i) {
+    auto e = order[i].first;
+    auto f = order[i].second;
+    std::map<value_type, pair_type> edges;
+    auto rule = thread_flags::no_rule();
+    if (e != dead()) {
+      for (const auto& edge : exact.children[e]) {
+        edges.emplace(edge.first, pair_type(edge.second, dead()));
+      }
+      rule = exact.rules[e];
+    }
+    if (f != dead()) {
+      for (const auto& edge : folded.children[f]) {
+        for (auto ch : {edge.first, facet->toupper(edge.first)}) {
+          auto found = edges.emplace(ch, pair_type(dead(), dead())).first;
+          found->second.second = edge.second;
+        }
+      }
+      rule = std::min<size_type>(rule, folded.rules[f]);
+    }
+
+    rules.push_back(rule);
+    first_edge.push_back(labels.size());
+    for (const auto& edge : edges) {
+      auto number = numbers.emplace(edge.second, 
+          static_cast<node_type>(order.size()));
+      if (number.second) {
+        order.push_back(edge.second);
+      }
+      labels.push_back(edge.first);
+      targets.push_back(number.first->second);
+    }
+  }
+  first_edge.push_back(labels.size());
+}
+
+template <typename CharT>
+typename literal_trie<CharT>::node_type
+literal_trie<CharT>::next(node_type node, value_type ch) const {
+  auto first = labels.begin() + first_edge[node];
+  auto last = labels.begin() + first_edge[node + 1];
+  auto found = std::lower_bound(first, last, ch);
+  if (found == last || *found != ch) {
+    return dead();
+  }
+  return targets[found - labels.begin()];
+}
+
+template <typename CharT>
+class literal_trie_engine {
+ public:
+  using trie_type = literal_trie<CharT>;
+  using node_type = typename trie_type::node_type;
+
+  // The trie must outlive the engine.
+  explicit literal_trie_engine(const trie_type& t)
+    : trie {&t},
+      current {trie_type::root()} {}
+
+  match_state state() const;
+  // This is the smallest rule matched by the input so far.
+  std::size_t rule() const;
+
+  void update(CharT ch);
+  void initialize() {current = trie_type::root();}
+
+  // This returns the end of the longest match at the start of the range.
+  // If nothing matches, begin is returned. The second form also sets rule
+  // to the rule of that match, or to thread_flags::no_rule().
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end);
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end, std::size_t& rule);
+ private:
+  const trie_type* trie;
+  node_type current;
+
+  bool live() const {
+    return current != trie_type::dead() && trie->has_children(current);
+  }
+};
+
+template <typename CharT>
+match_state literal_trie_engine<CharT>::state() const {
+  if (current == trie_type::dead()) {
+    return match_state::MISMATCH;
+  }
+  bool matched {trie->rule(current) != thread_flags::no_rule()};
+  if (matched) {
+    return live()? match_state::MATCH : match_state::FINAL_MATCH;
+  }
+  return live()? match_state::UNDECIDED : match_state::MISMATCH;
+}
+
+template <typename CharT>
+std::size_t literal_trie_engine<CharT>::rule() const {
+  if (current == trie_type::dead()) {
+    return thread_flags::no_rule();
+  }
+  return trie->rule(current);
+}
+
+template <typename CharT>
+void literal_trie_engine<CharT>::update(CharT ch) {
+  if (current != trie_type::dead()) {
+    current = trie->next(current, ch);
+  }
+}
+
+template <typename CharT>
+template <typename ForwardIt>
+ForwardIt literal_trie_engine<CharT>::match(ForwardIt begin, ForwardIt end) {
+  std::size_t rule;
+  return match(begin, end, rule);
+}
+
+template <typename CharT>
+template <typename ForwardIt>
+ForwardIt literal_trie_engine<CharT>::match(ForwardIt begin, ForwardIt end,
+    std::size_t& rule) {
+  initialize();
+  rule = thread_flags::no_rule();
+  auto accepted = begin;
+  for (auto seek = begin; live() && seek != end;) {
+    update(*seek);
+    ++seek;
+    if (this->rule() != thread_flags::no_rule()) {
+      accepted = seek;
+      rule = this->rule();
+    }
+  }
+  return accepted;
+}
+
+}//namespace lex
+#endif// _literal_trie_h_
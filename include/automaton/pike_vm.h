@@ -0,0 +1,102 @@
+/*
+ * The pike_vm runs a program by keeping the set of all live instruction
+ * pointers. Every input character advances the whole set at once, so
+ * matching is O(program size * input length) in the worst case.
+ *
+ * The thread lists are sparse sets sized to the program when the vm is
+ * constructed. Neither update() nor initialize() allocate.
+ *
+ * The states reported have the same meaning as those of a matcher:
+ *  MATCH       The input so far matches and a longer input might too.
+ *  FINAL_MATCH The input so far matches and no longer input can.
+ *  UNDECIDED   The input so far does not match but a longer input might.
+ *  MISMATCH    Neither this input nor any extension of it matches.
+ */
+
+#ifndef _pike_vm_h_
+#define _pike_vm_h_
+
+#include "automaton/closure.h"
+#include "automaton/program.h"
+#include "data_structures/sparse_set.h"
+#include "regex_types.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace lex {
+
+template <typename CharT, typename Traits>
+class pike_vm {
+ public:
+  using value_type = CharT;
+  using traits_type = Traits;
+  using program_type = program<CharT, Traits>;
+  using program_pointer = std::shared_ptr<const program_type>;
+  using index_type = std::size_t;
+
+  explicit pike_vm(program_pointer p);
+
+  match_state state() const {return flags.state();}
+
+  // This advances every live thread over ch.
+  void update(value_type ch);
+  // This returns the vm to the start of the program.
+  void initialize();
+
+  // This returns the end of the longest match at the start of the range.
+  // If nothing matches, begin is returned. The vm is initialized first, so
+  // any previous updates are discarded.
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end);
+ private:
+  program_pointer prog;
+  sparse_set<index_type> current;
+  sparse_set<index_type> next;
+  std::vector<index_type> stack;
+  thread_flags flags;
+};
+
+template <typename CharT, typename Traits>
+pike_vm<CharT, Traits>::pike_vm(program_pointer p)
+  : prog {std::move(p)},
+    current(prog->size() + 1),
+    next(prog->size() + 1),
+    stack(prog->size() + 1) {
+  initialize();
+}
+
+template <typename CharT, typename Traits>
+void pike_vm<CharT, Traits>::initialize() {
+  current.clear();
+  flags.clear();
+  add_closure(*prog, current, stack, 0, flags);
+}
+
+template <typename CharT, typename Traits>
+void pike_vm<CharT, Traits>::update(value_type ch) {
+  if (state() == match_state::MISMATCH) {
+    return;
+  }
+  step(*prog, current, next, stack, ch, flags);
+  current.swap(next);
+}
+
+template <typename CharT, typename Traits>
+template <typename ForwardIt>
+ForwardIt pike_vm<CharT, Traits>::match(ForwardIt begin, ForwardIt end) {
+  initialize();
+  auto accepted = begin;
+  for (auto seek = begin; flags.live && seek != end;) {
+    update(*seek);
+    ++seek;
+    if (flags.matched()) {
+      accepted = seek;
+    }
+  }
+  return accepted;
+}
+
+}//namespace lex
+#endif// _pike_vm_h_
@@ -0,0 +1,272 @@
+/*
+ * A program is the flat form of a compiled regex: a contiguous array of
+ * Thompson NFA instructions. It is produced by lowering a matcher tree into
+ * a program_builder and it is run by one of the engines in this directory.
+ *
+ * Instructions:
+ *  CHAR ch     consumes ch, then continues at pc + 1.
+ *  PRED p c    consumes any char satisfying predicate p, then pc + 1. If
+ *              c is not null, p accepts exactly the cases of c, which is
+ *              in lower case. Engines may ignore c.
+ *  SPLIT x y   continues at both x and y without consuming anything.
+ *  JUMP x      continues at x without consuming anything.
+ *  MATCH r     accepts the input consumed so far as a match of rule r.
+ *
+ * Execution always starts at pc 0. A program is never modified after it has
+ * been released by its builder.
+ *
+ * When a program is released its byte values are partitioned into
+ * equivalence classes: two bytes are in the same class if every consuming
+ * instruction accepts both or neither of them. Automata over single byte
+ * characters index their transition tables by class instead of by byte.
+ */
+
+#ifndef _program_h_
+#define _program_h_
+
+#include "regex_types.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace lex {
+
+enum class opcode : unsigned char {CHAR, PRED, SPLIT, JUMP, MATCH};
+
+template <typename CharT>
+struct instruction {
+  using value_type = CharT;
+  using index_type = std::size_t;
+
+  instruction() = default;
+  instruction(opcode o, value_type c, index_type a, index_type b)
+    : op {o},
+      ch {c},
+      x {a},
+      y {b} {}
+
+  // Only CHAR and PRED instructions consume input.
+  bool consumes() const {return op == opcode::CHAR || op == opcode::PRED;}
+
+  opcode op {opcode::MATCH};
+  value_type ch {'\0'};
+  index_type x {0};
+  index_type y {0};
+};
+
+template <typename CharT, typename Traits>
+class program_builder;
+
+template <typename CharT, typename Traits>
+class program {
+ public:
+  using value_type = CharT;
+  using traits_type = Traits;
+  using instruction_type = instruction<CharT>;
+  using predicate_type = predicate_type_t<CharT>;
+  using size_type = std::size_t;
+  using const_iterator =
+    typename std::vector<instruction_type>::const_iterator;
+
+  size_type size() const {return code.size();}
+  bool empty() const {return code.empty();}
+  const instruction_type& operator[](size_type pc) const {return code[pc];}
+  const_iterator begin() const {return code.begin();}
+  const_iterator end() const {return code.end();}
+
+  // The number of MATCH instructions, i.e. the number of distinct rules.
+  size_type rule_count() const {return rules;}
+
+  // This decides whether a consuming instruction accepts ch.
+  bool accepts(const instruction_type& ins, value_type ch) const;
+
+  // The byte equivalence classes. Every class has a representative byte
+  // which may stand in for every other byte of its class.
+  size_type class_count() const {return representatives.size();}
+  unsigned char byte_class(unsigned char byte) const {return classes[byte];}
+  unsigned char representative(size_type c) const {
+    return representatives[c];
+  }
+  const std::vector<unsigned char>& class_map() const {return classes;}
+ private:
+  std::vector<instruction_type> code;
+  std::vector<predicate_type> predicates;
+  size_type rules {0};
+  std::vector<unsigned char> classes = std::vector<unsigned char>(256, 0);
+  std::vector<unsigned char> representatives {0};
+
+  void compute_classes();
+
+  friend class program_builder<CharT, Traits>;
+};
+
+template <typename CharT, typename Traits>
+bool program<CharT, Traits>::accepts(const instruction_type& ins,
+    value_type ch) const {
+  switch (ins.op) {
+  case opcode::CHAR:
+    return ins.ch == ch;
+  case opcode::PRED:
+    return predicates[ins.x](ch);
+  default:
+    return false;
+  }
+}
+
+// Classes are refined one consuming instruction at a time. Each existing
+// class splits into the bytes the instruction accepts and those it does
+// not.
+template <typename CharT, typename Traits>
+void program<CharT, Traits>::compute_classes() {
+  const size_type byte_count = 256;
+  std::vector<int> split;
+  size_type count {1};
+  classes.assign(byte_count, 0);
+  for (const auto& ins : code) {
+    if (!ins.consumes()) continue;
+    split.assign(2 * count, -1);
+    size_type next_count {0};
+    for (size_type byte = 0; byte < byte_count; ++byte) {
+      auto side = accepts(ins, static_cast<value_type>(
+            static_cast<unsigned char>(byte)))? 1 : 0;
+      auto& id = split[2 * classes[byte] + side];
+      if (id < 0) {
+        id = static_cast<int>(next_count++);
+      }
+      classes[byte] = static_cast<unsigned char>(id);
+    }
+    count = next_count;
+  }
+
+  representatives.assign(count, 0);
+  for (size_type byte = byte_count; byte-- > 0;) {
+    representatives[classes[byte]] = static_cast<unsigned char>(byte);
+  }
+}
+
+// Matchers lower themselves into a program_builder. Each lowering appends
+// a block of code whose exits all fall through to the end of the block, so
+// sequencing two blocks is simply emitting one after the other.
+template <typename CharT, typename Traits>
+class program_builder {
+ public:
+  using program_type = program<CharT, Traits>;
+  using value_type = CharT;
+  using predicate_type = typename program_type::predicate_type;
+  using index_type = std::size_t;
+
+  // The pc of the next emitted instruction.
+  index_type position() const {return prog.code.size();}
+
+  void emit_char(value_type ch) {emit(opcode::CHAR, ch, 0, 0);}
+  // A folded predicate accepts exactly the cases of folded.
+  void emit_predicate(predicate_type pred, 
+      value_type folded = value_type('\0'));
+  index_type emit_split(index_type x, index_type y) {
+    return emit(opcode::SPLIT, value_type('\0'), x, y);
+  }
+  index_type emit_jump(index_type x) {
+    return emit(opcode::JUMP, value_type('\0'), x, 0);
+  }
+  void emit_match(index_type rule = 0);
+  // This appends a copy of a whole program. Its jumps are relocated and its
+  // MATCH instructions are relabeled with the given rule. The program must
+  // end with a MATCH instruction so that it never falls through.
+  void append(const program_type& other, index_type rule);
+  // Rule programs are joined like the branches of an alternation:
+  //      SPLIT L1, L2
+  //  L1: <rule 0>
+  //  L2: SPLIT L3, L4
+  //  L3: <rule 1>
+  //  L4: <rule 2>
+  // Each rule program ends with its own MATCH, so no JUMPs are needed.
+  // This appends one branch. The last one needs no SPLIT.
+  void append_rule(const program_type& other, index_type rule, bool last);
+
+  // These fill in targets that were unknown when the instruction was
+  // emitted.
+  void patch_x(index_type pc, index_type target) {prog.code[pc].x = target;}
+  void patch_y(index_type pc, index_type target) {prog.code[pc].y = target;}
+
+  program_type release();
+ private:
+  program_type prog;
+
+  index_type emit(opcode op, value_type ch, index_type x, index_type y);
+};
+
+template <typename CharT, typename Traits>
+typename program_builder<CharT, Traits>::index_type
+program_builder<CharT, Traits>::emit(opcode op, value_type ch,
+    index_type x, index_type y) {
+  prog.code.emplace_back(op, ch, x, y);
+  return prog.code.size() - 1;
+}
+
+template <typename CharT, typename Traits>
+void program_builder<CharT, Traits>::emit_predicate(predicate_type pred,
+    value_type folded) {
+  prog.predicates.push_back(std::move(pred));
+  emit(opcode::PRED, folded, prog.predicates.size() - 1, 0);
+}
+
+template <typename CharT, typename Traits>
+void program_builder<CharT, Traits>::append(const program_type& other,
+    index_type rule) {
+  auto offset = position();
+  auto pred_offset = prog.predicates.size();
+  prog.predicates.insert(prog.predicates.end(), other.predicates.begin(),
+      other.predicates.end());
+
+  for (auto ins : other.code) {
+    switch (ins.op) {
+    case opcode::PRED:
+      ins.x += pred_offset;
+      break;
+    case opcode::SPLIT:
+      ins.y += offset;
+      ins.x += offset;
+      break;
+    case opcode::JUMP:
+      ins.x += offset;
+      break;
+    case opcode::MATCH:
+      emit_match(rule);
+      continue;
+    default:
+      break;
+    }
+    prog.code.push_back(ins);
+  }
+}
+
+template <typename CharT, typename Traits>
+void program_builder<CharT, Traits>::append_rule(const program_type& other,
+    index_type rule, bool last) {
+  if (last) {
+    append(other, rule);
+    return;
+  }
+  auto split = emit_split(position() + 1, 0);
+  append(other, rule);
+  patch_y(split, position());
+}
+
+template <typename CharT, typename Traits>
+typename program_builder<CharT, Traits>::program_type
+program_builder<CharT, Traits>::release() {
+  prog.compute_classes();
+  return std::move(prog);
+}
+
+template <typename CharT, typename Traits>
+void program_builder<CharT, Traits>::emit_match(index_type rule) {
+  emit(opcode::MATCH, value_type('\0'), rule, 0);
+  if (prog.rules <= rule) {
+    prog.rules = rule + 1;
+  }
+}
+
+}//namespace lex
+#endif// _program_h_
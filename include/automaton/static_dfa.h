@@ -0,0 +1,680 @@
+/*
+ * This file turns regexes into dfa tables at compile time. Every stage --
+ * parsing, lowering to a program, computing byte classes and subset
+ * construction -- is a constexpr function, so the finished tables are
+ * constants and live in read only data.
+ *
+ * The patterns of a rule set are given by types. Each type must have a
+ *   static constexpr const char* pattern();
+ * returning a string literal. The supported syntax is the part of POSIX
+ * extended syntax, the default of a regex, that reads the same over single
+ * bytes in the "C" locale:
+ *   literals and .
+ *   \ before one of . [ \ ( ) * + ? { | ^ $, which stands for itself
+ *   bracket expressions with ranges of ASCII characters, negation,
+ *     [:class:] and [.x.] and [=x=] of a single letter; a \ in a bracket
+ *     is an ordinary character
+ *   groups, alternation and the quantifiers * + ? {m} {m,} {m,n}
+ * Any other construct is a compile time error, as is a malformed pattern
+ * or a rule set whose dfa needs more than static_state_limit() states.
+ * This includes the ECMAScript escapes such as \d and \n, anchors and
+ * empty groups, which a regex compiled with static_syntax() rejects or
+ * reads differently. A pattern that compiles therefore matches exactly
+ * what that regex matches in the "C" locale.
+ *
+ * The program built here has the same shape as the runtime one (see
+ * program.h), except that every consuming instruction is a PRED holding a
+ * set of bytes. The tables have the same meaning as those of a dfa.
+ */
+
+#ifndef _static_dfa_h_
+#define _static_dfa_h_
+
+#include "automaton/program.h"
+#include "data_structures/byte_set.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace lex {
+namespace detail {
+
+// Evaluating the throw makes the enclosing constant expression invalid, so
+// a failed check is reported by the compiler.
+constexpr bool static_regex_check(bool condition, const char* what) {
+  return condition? true : throw std::invalid_argument(what);
+}
+
+// The runtime syntax whose meaning static patterns keep.
+constexpr regex_constants::syntax_option_type static_syntax() {
+  return regex_constants::extended;
+}
+
+constexpr std::size_t static_npos() {
+  return std::numeric_limits<std::size_t>::max();
+}
+
+struct static_instruction {
+  opcode op {opcode::MATCH};
+  byte_set set {};
+  std::size_t x {0};
+  std::size_t y {0};
+};
+
+// A static_program with room for N instructions. Instructions past the
+// end are counted but not stored, so a static_program<1> measures the
+// size that a pattern needs.
+template <std::size_t N>
+struct static_program {
+  static_instruction code[N] {};
+  std::size_t size {0};
+
+  constexpr std::size_t emit(opcode op, const byte_set& set,
+      std::size_t x, std::size_t y) {
+    if (size < N) {
+      code[size].op = op;
+      code[size].set = set;
+      code[size].x = x;
+      code[size].y = y;
+    }
+    return size++;
+  }
+  constexpr void patch_x(std::size_t pc, std::size_t target) {
+    if (pc < N) code[pc].x = target;
+  }
+  constexpr void patch_y(std::size_t pc, std::size_t target) {
+    if (pc < N) code[pc].y = target;
+  }
+  // These return static_npos() for instructions that were not stored.
+  constexpr std::size_t x(std::size_t pc) const {
+    return pc < N? code[pc].x : static_npos();
+  }
+  constexpr std::size_t y(std::size_t pc) const {
+    return pc < N? code[pc].y : static_npos();
+  }
+};
+
+constexpr bool static_name_is(const char* s, std::size_t n,
+    const char* name) {
+  for (std::size_t i = 0; i < n; ++i) {
+    if (name[i] != s[i]) return false;
+  }
+  return name[n] == '\0';
+}
+
+template <typename... Names>
+constexpr bool static_name_is(const char* s, std::size_t n,
+    const char* name, Names... names) {
+  return static_name_is(s, n, name) || static_name_is(s, n, names...);
+}
+
+// The classes of the "C" locale, by the names std::regex_traits accepts.
+constexpr byte_set static_named_class(const char* s, std::size_t n) {
+  byte_set set {};
+  bool xdigit {static_name_is(s, n, "xdigit")};
+  if (static_name_is(s, n, "alnum", "alpha", "w", "upper", "xdigit")) {
+    set.insert('A', xdigit? 'F' : 'Z');
+  }
+  if (static_name_is(s, n, "alnum", "alpha", "w", "lower", "xdigit")) {
+    set.insert('a', xdigit? 'f' : 'z');
+  }
+  if (static_name_is(s, n, "alnum", "w", "digit", "d", "xdigit")) {
+    set.insert('0', '9');
+  }
+  if (static_name_is(s, n, "w")) {
+    set.insert('_');
+  }
+  if (static_name_is(s, n, "space", "s")) {
+    set.insert(' ');
+    set.insert('\t', '\r');
+  }
+  if (static_name_is(s, n, "blank")) {
+    set.insert(' ');
+    set.insert('\t');
+  }
+  if (static_name_is(s, n, "cntrl")) {
+    set.insert(0, 31);
+    set.insert(127);
+  }
+  if (static_name_is(s, n, "print", "graph")) {
+    set.insert(static_name_is(s, n, "print")? 32 : 33, 126);
+  }
+  if (static_name_is(s, n, "punct")) {
+    set.insert(33, 47);
+    set.insert(58, 64);
+    set.insert(91, 96);
+    set.insert(123, 126);
+  }
+  bool empty {true};
+  for (auto word : set.words) {
+    empty = empty && word == 0;
+  }
+  static_regex_check(!empty, "unknown character class in pattern");
+  return set;
+}
+
+// A static_compiler lowers one pattern into a static_program. Every
+// method takes the index of the pattern character to start at and returns
+// the index just past what it read.
+template <std::size_t N>
+class static_compiler {
+ public:
+  constexpr static_compiler(const char* pattern, static_program<N>& p)
+    : s {pattern},
+      prog {p} {}
+
+  constexpr void compile() {
+    static_regex_check(s[0] != '\0', "empty pattern");
+    auto i = alternation(0);
+    static_regex_check(s[i] == '\0', "unmatched ) in pattern");
+  }
+
+  template <std::size_t M>
+  friend class static_compiler;
+ private:
+  const char* s;
+  static_program<N>& prog;
+
+  constexpr std::size_t alternation(std::size_t i);
+  constexpr std::size_t concatenation(std::size_t i);
+  constexpr std::size_t piece(std::size_t i);
+  constexpr std::size_t atom(std::size_t i);
+  constexpr std::size_t bracket(std::size_t i, byte_set& set) const;
+  constexpr std::size_t escape(std::size_t i, byte_set& set) const;
+  constexpr std::size_t number(std::size_t i, std::size_t& n) const;
+  constexpr std::size_t atom_end(std::size_t i) const;
+};
+
+// Every branch is guarded by a SPLIT whose second target is the next
+// branch, just like alternation_impl::emit(). The last branch has nothing
+// to skip to, so its SPLIT has the same target twice. The JUMPs out of the
+// branches are chained through their targets until they are patched.
+template <std::size_t N>
+constexpr std::size_t static_compiler<N>::alternation(std::size_t i) {
+  auto pending = static_npos();
+  while (true) {
+    auto split = prog.emit(opcode::SPLIT, {}, prog.size + 1, 0);
+    i = concatenation(i);
+    if (s[i] != '|') {
+      prog.patch_y(split, split + 1);
+      break;
+    }
+    pending = prog.emit(opcode::JUMP, {}, pending, 0);
+    prog.patch_y(split, prog.size);
+    ++i;
+  }
+  while (pending != static_npos()) {
+    auto next = prog.x(pending);
+    prog.patch_x(pending, prog.size);
+    pending = next;
+  }
+  return i;
+}
+
+template <std::size_t N>
+constexpr std::size_t static_compiler<N>::concatenation(std::size_t i) {
+  while (s[i] != '\0' && s[i] != '|' && s[i] != ')') {
+    i = piece(i);
+  }
+  return i;
+}
+
+// A quantified atom is lowered like matcher_replicator_impl::emit(). The
+// atom is simply compiled again for every copy.
+template <std::size_t N>
+constexpr std::size_t static_compiler<N>::piece(std::size_t i) {
+  const auto unbounded = static_npos();
+  auto after = atom_end(i);
+  std::size_t lower {1};
+  std::size_t upper {1};
+  auto end = after;
+  switch (s[after]) {
+  case '*':
+    lower = 0;
+    upper = unbounded;
+    ++end;
+    break;
+  case '+':
+    upper = unbounded;
+    ++end;
+    break;
+  case '?':
+    lower = 0;
+    ++end;
+    break;
+  case '{':
+    end = number(after + 1, lower);
+    upper = lower;
+    if (s[end] == ',') {
+      upper = unbounded;
+      if (s[end + 1] != '}') {
+        end = number(end + 1, upper);
+      } else {
+        ++end;
+      }
+    }
+    static_regex_check(s[end] == '}', "bad repetition in pattern");
+    static_regex_check(lower <= upper, "bad repetition bounds in pattern");
+    ++end;
+    break;
+  }
+  static_regex_check(end == after || (s[end] != '*' && s[end] != '+' &&
+        s[end] != '?' && s[end] != '{'), "nested quantifier in pattern");
+
+  for (std::size_t count = 1; count < lower; ++count) {
+    atom(i);
+  }
+  if (upper == unbounded) {
+    if (lower == 0) {
+      auto loop = prog.emit(opcode::SPLIT, {}, prog.size + 1, 0);
+      atom(i);
+      prog.emit(opcode::JUMP, {}, loop, 0);
+      prog.patch_y(loop, prog.size);
+    } else {
+      auto loop = prog.size;
+      atom(i);
+      prog.emit(opcode::SPLIT, {}, loop, prog.size + 1);
+    }
+    return end;
+  }
+  if (lower != 0) {
+    atom(i);
+  }
+  // The optional copies are chained through their second targets.
+  auto pending = static_npos();
+  for (auto count = lower; count < upper; ++count) {
+    pending = prog.emit(opcode::SPLIT, {}, prog.size + 1, pending);
+    atom(i);
+  }
+  while (pending != static_npos()) {
+    auto next = prog.y(pending);
+    prog.patch_y(pending, prog.size);
+    pending = next;
+  }
+  return end;
+}
+
+template <std::size_t N>
+constexpr std::size_t static_compiler<N>::atom(std::size_t i) {
+  byte_set set {};
+  switch (s[i]) {
+  case '(':
+    static_regex_check(s[i + 1] != ')', "empty group in pattern");
+    i = alternation(i + 1);
+    static_regex_check(s[i] == ')', "missing ) in pattern");
+    return i + 1;
+  case '[':
+    i = bracket(i, set);
+    break;
+  case '.':
+    set.invert();
+    ++i;
+    break;
+  case '\\':
+    i = escape(i + 1, set);
+    break;
+  case '\0': case ')': case '|':
+  case '*': case '+': case '?': case '{':
+    static_regex_check(false, "nothing to repeat in pattern");
+    break;
+  case '^': case '$':
+    static_regex_check(false, "anchor in pattern");
+    break;
+  default:
+    set.insert(static_cast<unsigned char>(s[i]));
+    ++i;
+    break;
+  }
+  prog.emit(opcode::PRED, set, 0, 0);
+  return i;
+}
+
+// The end of an atom is found by compiling it into a scratch program.
+template <std::size_t N>
+constexpr std::size_t static_compiler<N>::atom_end(std::size_t i) const {
+  static_program<1> scratch {};
+  static_compiler<1> measure(s, scratch);
+  return measure.atom(i);
+}
+
+// Only the characters that are special outside a bracket may be escaped.
+template <std::size_t N>
+constexpr std::size_t
+static_compiler<N>::escape(std::size_t i, byte_set& set) const {
+  auto ch = s[i];
+  static_regex_check(ch != '\0', "trailing \\ in pattern");
+  bool special {false};
+  for (auto p = ".[\\()*+?{|^$"; *p; ++p) {
+    special = special || *p == ch;
+  }
+  static_regex_check(special, "unsupported escape in pattern");
+  set.insert(static_cast<unsigned char>(ch));
+  return i + 1;
+}
+
+// A ] right after the opening [ or [^ is an ordinary character, and so is
+// a \. A class or collating element may not end a range, and the only
+// collating elements are single letters, the ones a regex knows by name.
+template <std::size_t N>
+constexpr std::size_t
+static_compiler<N>::bracket(std::size_t i, byte_set& set) const {
+  ++i;
+  bool negate {s[i] == '^'};
+  if (negate) ++i;
+  bool first {true};
+  while (first || s[i] != ']') {
+    static_regex_check(s[i] != '\0', "missing ] in pattern");
+    first = false;
+    if (s[i] == '[' && (s[i + 1] == ':' || s[i + 1] == '.' ||
+          s[i + 1] == '=')) {
+      auto kind = s[i + 1];
+      auto start = i + 2;
+      auto end = start;
+      while (s[end] != '\0' && (s[end] != kind || s[end + 1] != ']')) {
+        ++end;
+      }
+      static_regex_check(s[end] != '\0', "missing ] in pattern");
+      if (kind == ':') {
+        set.insert(static_named_class(s + start, end - start));
+      } else {
+        auto ch = s[start];
+        static_regex_check(end == start + 1 && ((ch >= 'a' && ch <= 'z') ||
+              (ch >= 'A' && ch <= 'Z')),
+            "unsupported collating element in pattern");
+        set.insert(static_cast<unsigned char>(s[start]));
+      }
+      i = end + 2;
+      static_regex_check(s[i] != '-' || s[i + 1] == ']',
+          "unsupported range in pattern");
+      continue;
+    }
+    auto lo = static_cast<unsigned char>(s[i]);
+    if (s[i + 1] == '-' && s[i + 2] != ']' && s[i + 2] != '\0') {
+      auto hi = static_cast<unsigned char>(s[i + 2]);
+      static_regex_check(s[i + 2] != '[', "unsupported range in pattern");
+      static_regex_check(lo < 128 && hi < 128, "non-ASCII range in pattern");
+      static_regex_check(lo <= hi, "bad range in pattern");
+      set.insert(lo, hi);
+      i += 3;
+    } else {
+      set.insert(lo);
+      ++i;
+    }
+  }
+  if (negate) {
+    set.invert();
+  }
+  return i + 1;
+}
+
+template <std::size_t N>
+constexpr std::size_t
+static_compiler<N>::number(std::size_t i, std::size_t& n) const {
+  static_regex_check(s[i] >= '0' && s[i] <= '9', "bad repetition in pattern");
+  n = 0;
+  while (s[i] >= '0' && s[i] <= '9') {
+    n = 10 * n + (s[i] - '0');
+    ++i;
+  }
+  return i;
+}
+
+// The rules are joined the same way a translator joins them.
+template <std::size_t N, typename... Rules>
+constexpr static_program<N> compile_static_rules() {
+  static_assert(sizeof...(Rules) > 0, "A rule set needs at least one rule.");
+  static_program<N> prog {};
+  const char* patterns[] = {Rules::pattern()...};
+  const auto count = sizeof...(Rules);
+  for (std::size_t rule = 0; rule < count; ++rule) {
+    auto split = static_npos();
+    if (rule + 1 != count) {
+      split = prog.emit(opcode::SPLIT, {}, prog.size + 1, 0);
+    }
+    static_compiler<N>(patterns[rule], prog).compile();
+    prog.emit(opcode::MATCH, {}, rule, 0);
+    if (split != static_npos()) {
+      prog.patch_y(split, prog.size);
+    }
+  }
+  return prog;
+}
+
+// Two bytes are in the same class if every instruction accepts both or
+// neither of them.
+struct static_byte_classes {
+  unsigned char map[256] {};
+  unsigned char representative[256] {};
+  std::size_t count {0};
+};
+
+template <std::size_t N>
+constexpr static_byte_classes
+compute_static_classes(const static_program<N>& prog) {
+  static_byte_classes classes {};
+  for (unsigned byte = 0; byte < 256; ++byte) {
+    auto b = static_cast<unsigned char>(byte);
+    bool found {false};
+    for (std::size_t c = 0; !found && c < classes.count; ++c) {
+      auto r = classes.representative[c];
+      bool same {true};
+      for (std::size_t pc = 0; same && pc < prog.size; ++pc) {
+        const auto& ins = prog.code[pc];
+        same = ins.op != opcode::PRED ||
+          ins.set.contains(b) == ins.set.contains(r);
+      }
+      if (same) {
+        classes.map[byte] = static_cast<unsigned char>(c);
+        found = true;
+      }
+    }
+    if (!found) {
+      classes.representative[classes.count] = b;
+      classes.map[byte] = static_cast<unsigned char>(classes.count++);
+    }
+  }
+  return classes;
+}
+
+template <std::size_t N>
+struct pc_set {
+  static constexpr std::size_t word_count = (N + 63) / 64;
+  std::uint64_t words[word_count] {};
+
+  constexpr bool contains(std::size_t pc) const {
+    return (words[pc / 64] >> (pc % 64)) & 1;
+  }
+  constexpr void insert(std::size_t pc) {
+    words[pc / 64] |= std::uint64_t(1) << (pc % 64);
+  }
+  constexpr bool operator==(const pc_set& other) const {
+    for (std::size_t i = 0; i < word_count; ++i) {
+      if (words[i] != other.words[i]) return false;
+    }
+    return true;
+  }
+};
+
+inline constexpr std::size_t static_state_limit() {return 256;}
+
+// The result of subset construction, with room for MaxStates states.
+template <std::size_t N, std::size_t Classes, std::size_t MaxStates>
+struct static_subset {
+  pc_set<N> threads[MaxStates] {};
+  std::uint32_t rules[MaxStates] {};
+  bool live[MaxStates] {};
+  std::size_t next[MaxStates][Classes] {};
+  std::size_t count {0};
+  std::size_t start {0};
+};
+
+// This adds the closure of pc to visited. Only consuming instructions are
+// added to threads, which is the key of a state.
+template <std::size_t N>
+constexpr void static_closure(const static_program<N>& prog,
+    pc_set<N>& visited, pc_set<N>& threads, std::size_t pc,
+    std::uint32_t& rule) {
+  std::size_t stack[N + 1] {};
+  std::size_t top {0};
+  if (!visited.contains(pc)) {
+    visited.insert(pc);
+    stack[top++] = pc;
+  }
+  while (top) {
+    pc = stack[--top];
+    const auto& ins = prog.code[pc];
+    switch (ins.op) {
+    case opcode::CHAR:
+    case opcode::PRED:
+      threads.insert(pc);
+      break;
+    case opcode::MATCH:
+      if (ins.x < rule) {
+        rule = static_cast<std::uint32_t>(ins.x);
+      }
+      break;
+    case opcode::JUMP:
+      if (!visited.contains(ins.x)) {
+        visited.insert(ins.x);
+        stack[top++] = ins.x;
+      }
+      break;
+    case opcode::SPLIT:
+      if (!visited.contains(ins.y)) {
+        visited.insert(ins.y);
+        stack[top++] = ins.y;
+      }
+      if (!visited.contains(ins.x)) {
+        visited.insert(ins.x);
+        stack[top++] = ins.x;
+      }
+      break;
+    }
+  }
+}
+
+template <std::size_t N, std::size_t Classes, std::size_t MaxStates>
+constexpr std::size_t
+add_static_state(static_subset<N, Classes, MaxStates>& result,
+    const pc_set<N>& threads, std::uint32_t rule) {
+  for (std::size_t s = 0; s < result.count; ++s) {
+    if (result.rules[s] == rule && result.threads[s] == threads) {
+      return s;
+    }
+  }
+  static_regex_check(result.count < MaxStates,
+      "too many states in static dfa");
+  result.threads[result.count] = threads;
+  result.rules[result.count] = rule;
+  return result.count++;
+}
+
+template <std::size_t N, std::size_t Classes, std::size_t MaxStates>
+constexpr static_subset<N, Classes, MaxStates>
+build_static_subset(const static_program<N>& prog,
+    const static_byte_classes& classes) {
+  const auto no_rule = std::numeric_limits<std::uint32_t>::max();
+  static_subset<N, Classes, MaxStates> result {};
+  // State 0 is the dead state.
+  add_static_state(result, pc_set<N>{}, no_rule);
+
+  pc_set<N> visited {};
+  pc_set<N> threads {};
+  auto rule = no_rule;
+  static_closure(prog, visited, threads, 0, rule);
+  result.start = add_static_state(result, threads, rule);
+
+  for (std::size_t s = 1; s < result.count; ++s) {
+    for (std::size_t c = 0; c < Classes; ++c) {
+      auto byte = classes.representative[c];
+      visited = pc_set<N>{};
+      threads = pc_set<N>{};
+      rule = no_rule;
+      for (std::size_t pc = 0; pc < prog.size; ++pc) {
+        if (result.threads[s].contains(pc) &&
+            prog.code[pc].set.contains(byte)) {
+          static_closure(prog, visited, threads, pc + 1, rule);
+        }
+      }
+      result.next[s][c] = add_static_state(result, threads, rule);
+      if (result.next[s][c] != 0) {
+        result.live[s] = true;
+      }
+    }
+  }
+  return result;
+}
+
+template <std::size_t States>
+using static_state_t =
+  std::conditional_t<(States <= 256), std::uint8_t,
+    std::conditional_t<(States <= 65536), std::uint16_t, std::uint32_t>>;
+
+// The finished tables, sized exactly. They have the same meaning as the
+// tables of a dfa.
+template <std::size_t States, std::size_t Classes>
+struct static_dfa_table {
+  using state_type = static_state_t<States>;
+
+  unsigned char classes[256] {};
+  state_type next[States][Classes] {};
+  std::uint32_t rules[States] {};
+  bool live[States] {};
+  state_type start {0};
+};
+
+template <std::size_t States, std::size_t Classes, typename Subset>
+constexpr static_dfa_table<States, Classes>
+compact_static_dfa(const Subset& subset,
+    const static_byte_classes& classes) {
+  using state_type = static_state_t<States>;
+  static_dfa_table<States, Classes> table {};
+  for (std::size_t byte = 0; byte < 256; ++byte) {
+    table.classes[byte] = classes.map[byte];
+  }
+  for (std::size_t s = 0; s < States; ++s) {
+    for (std::size_t c = 0; c < Classes; ++c) {
+      table.next[s][c] = static_cast<state_type>(subset.next[s][c]);
+    }
+    table.rules[s] = subset.rules[s];
+    table.live[s] = subset.live[s];
+  }
+  table.start = static_cast<state_type>(subset.start);
+  return table;
+}
+
+template <typename... Rules>
+constexpr std::size_t static_program_size() {
+  return compile_static_rules<1, Rules...>().size;
+}
+
+// Each stage is a variable template, so it is evaluated once per rule set.
+template <typename... Rules>
+constexpr auto static_program_v =
+  compile_static_rules<static_program_size<Rules...>(), Rules...>();
+
+template <typename... Rules>
+constexpr auto static_classes_v =
+  compute_static_classes(static_program_v<Rules...>);
+
+template <typename... Rules>
+constexpr auto static_subset_v = build_static_subset<
+    static_program_size<Rules...>(), static_classes_v<Rules...>.count,
+    static_state_limit()
+  >(static_program_v<Rules...>, static_classes_v<Rules...>);
+
+}//namespace detail
+
+// This is the complete dfa of a rule set. The earliest rule wins among
+// matches of the same length.
+template <typename... Rules>
+constexpr auto static_dfa_v = detail::compact_static_dfa<
+    detail::static_subset_v<Rules...>.count,
+    detail::static_classes_v<Rules...>.count
+  >(detail::static_subset_v<Rules...>, detail::static_classes_v<Rules...>);
+
+}//namespace lex
+#endif// _static_dfa_h_
@@ -0,0 +1,209 @@
+/*
+ * An arena is a monotonic allocator. It hands out memory from large blocks
+ * by bumping a pointer, never frees anything on its own, and returns all of
+ * its blocks at once when it is released or destroyed. An arena is not
+ * thread safe; each thread should use its own.
+ *
+ * Objects allocated from an arena must be destroyed before it is released.
+ * Their destructors run as usual, but their memory is only reclaimed in
+ * bulk.
+ *
+ * Code that builds many short lived objects, such as the matcher trees made
+ * while compiling a regex, allocates through the arena that is current on
+ * its thread. An arena_scope makes an arena current for its lifetime:
+ *   arena region;
+ *   {
+ *     arena_scope scope(region);
+ *     translator_type rules(list.begin(), list.end());
+ *   }
+ * With no arena current, everything comes from the global heap.
+ *
+ * arena_allocator is a standard allocator over an arena. A default
+ * constructed arena_allocator uses the current arena, and so does a
+ * container copied through one. That does not make copies independent of
+ * the arena, though. Matchers keep parts such as their initial_state lists
+ * and replicated matchers in shared_ptrs made by allocate_shared, and
+ * clone() shares those rather than copying them. A matcher built under an
+ * arena, and every copy of it, wherever made, must not outlive the arena.
+ * Compiled programs hold none of this, so they may.
+ */
+
+#ifndef _arena_h_
+#define _arena_h_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace lex {
+
+class arena {
+ public:
+  explicit arena(std::size_t block = 1 << 14)
+    : block_size {block} {}
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+  ~arena() {release();}
+
+  void* allocate(std::size_t bytes, std::size_t alignment);
+  // This frees every block.
+  void release();
+
+  // The number of bytes handed out since the last release.
+  std::size_t bytes_allocated() const {return used;}
+  std::size_t block_count() const {return blocks;}
+ private:
+  struct block_header {
+    block_header* next;
+  };
+
+  std::size_t block_size;
+  block_header* head {nullptr};
+  char* cursor {nullptr};
+  char* limit {nullptr};
+  std::size_t used {0};
+  std::size_t blocks {0};
+};
+
+inline void* arena::allocate(std::size_t bytes, std::size_t alignment) {
+  auto align = [alignment] (char* p) {
+    auto address = reinterpret_cast<std::uintptr_t>(p);
+    auto padding = (alignment - address % alignment) % alignment;
+    return p + padding;
+  };
+  auto p = cursor? align(cursor) : nullptr;
+  if (!p || p + bytes > limit) {
+    // Requests larger than a block get a block of their own.
+    auto size = sizeof(block_header) + alignment +
+      (bytes > block_size? bytes : block_size);
+    auto fresh = static_cast<block_header*>(::operator new(size));
+    fresh->next = head;
+    head = fresh;
+    ++blocks;
+    cursor = reinterpret_cast<char*>(fresh + 1);
+    limit = reinterpret_cast<char*>(fresh) + size;
+    p = align(cursor);
+  }
+  cursor = p + bytes;
+  used += bytes;
+  return p;
+}
+
+inline void arena::release() {
+  while (head) {
+    auto next = head->next;
+    ::operator delete(head);
+    head = next;
+  }
+  cursor = limit = nullptr;
+  used = blocks = 0;
+}
+
+// The slot holding the current arena of this thread.
+inline arena*& current_arena_slot() {
+  static thread_local arena* current {nullptr};
+  return current;
+}
+
+inline arena* current_arena() {return current_arena_slot();}
+
+// An arena_scope makes an arena, or no arena, current until it is
+// destroyed. Scopes may be nested.
+class arena_scope {
+ public:
+  explicit arena_scope(arena& region)
+    : arena_scope(&region) {}
+  explicit arena_scope(arena* region)
+    : previous {current_arena_slot()} {
+    current_arena_slot() = region;
+  }
+  arena_scope(const arena_scope&) = delete;
+  arena_scope& operator=(const arena_scope&) = delete;
+  ~arena_scope() {current_arena_slot() = previous;}
+ private:
+  arena* previous;
+};
+
+template <typename T>
+class arena_allocator {
+ public:
+  using value_type = T;
+
+  arena_allocator()
+    : region {current_arena()} {}
+  explicit arena_allocator(arena* r)
+    : region {r} {}
+  template <typename U>
+  arena_allocator(const arena_allocator<U>& other)
+    : region {other.get_arena()} {}
+
+  T* allocate(std::size_t n);
+  // Memory from an arena is only reclaimed when the arena is released.
+  void deallocate(T* p, std::size_t) {
+    if (!region) {
+      ::operator delete(p);
+    }
+  }
+
+  arena_allocator select_on_container_copy_construction() const {
+    return arena_allocator();
+  }
+
+  arena* get_arena() const {return region;}
+ private:
+  arena* region;
+};
+
+template <typename T>
+T* arena_allocator<T>::allocate(std::size_t n) {
+  if (region) {
+    return static_cast<T*>(region->allocate(n * sizeof(T), alignof(T)));
+  }
+  return static_cast<T*>(::operator new(n * sizeof(T)));
+}
+
+template <typename T, typename U>
+bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b) {
+  return a.get_arena() == b.get_arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b) {
+  return !(a == b);
+}
+
+// A deleter that knows whether its object came from an arena. Objects from
+// an arena are only destroyed; all others are deleted.
+struct arena_deleter {
+  arena* region {nullptr};
+
+  template <typename T>
+  void operator()(T* p) const {
+    if (region) {
+      p->~T();
+    } else {
+      delete p;
+    }
+  }
+};
+
+template <typename T>
+using arena_unique_ptr = std::unique_ptr<T, arena_deleter>;
+
+// This constructs an object in the current arena, or on the heap if there
+// is none.
+template <typename T, typename... Args>
+arena_unique_ptr<T> make_arena_unique(Args&&... args) {
+  auto region = current_arena();
+  if (!region) {
+    return arena_unique_ptr<T>(new T(std::forward<Args>(args)...));
+  }
+  auto memory = region->allocate(sizeof(T), alignof(T));
+  return arena_unique_ptr<T>(new (memory) T(std::forward<Args>(args)...),
+      arena_deleter {region});
+}
+
+}//namespace lex
+#endif// _arena_h_
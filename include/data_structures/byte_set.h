@@ -0,0 +1,41 @@
+/*
+ * A byte_set holds a set of byte values as a 256 bit bitmap. Every
+ * operation is constexpr, so a byte_set can be built at compile time.
+ */
+#ifndef _byte_set_h_
+#define _byte_set_h_
+
+#include <cstdint>
+
+namespace lex {
+namespace detail {
+
+struct byte_set {
+  std::uint64_t words[4] {0, 0, 0, 0};
+
+  constexpr bool contains(unsigned char b) const {
+    return (words[b / 64] >> (b % 64)) & 1;
+  }
+  constexpr void insert(unsigned char b) {
+    words[b / 64] |= std::uint64_t(1) << (b % 64);
+  }
+  constexpr void insert(unsigned lo, unsigned hi) {
+    for (auto b = lo; b <= hi; ++b) {
+      insert(static_cast<unsigned char>(b));
+    }
+  }
+  constexpr void insert(const byte_set& other) {
+    for (auto i = 0; i < 4; ++i) {
+      words[i] |= other.words[i];
+    }
+  }
+  constexpr void invert() {
+    for (auto i = 0; i < 4; ++i) {
+      words[i] = ~words[i];
+    }
+  }
+};
+
+}//namespace detail
+}//namespace lex
+#endif// _byte_set_h_
@@ -0,0 +1,49 @@
+/*
+ * is_contiguous_iterator tells whether an iterator type is known to walk
+ * over contiguous storage. For such iterators to_pointer() gives a plain
+ * pointer, so bulk algorithms (memchr, SIMD scans and the like) can be
+ * used on the range.
+ *
+ * Only pointers and the iterators of std::basic_string and std::vector are
+ * recognized.
+ */
+#ifndef _contiguous_iterator_h_
+#define _contiguous_iterator_h_
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace lex {
+
+template <typename Iterator>
+struct is_contiguous_iterator {
+ private:
+  using value_type = typename std::iterator_traits<Iterator>::value_type;
+  using string_type = std::basic_string<value_type>;
+  using vector_type = std::vector<value_type>;
+ public:
+  static constexpr bool value =
+    std::is_pointer<Iterator>::value ||
+    std::is_same<Iterator, typename string_type::iterator>::value ||
+    std::is_same<Iterator, typename string_type::const_iterator>::value ||
+    (!std::is_same<value_type, bool>::value &&
+     (std::is_same<Iterator, typename vector_type::iterator>::value ||
+      std::is_same<Iterator, typename vector_type::const_iterator>::value));
+};
+
+template <typename Iterator>
+constexpr bool is_contiguous_iterator<Iterator>::value;
+
+// The iterator must be dereferenceable, unless it is a pointer. To convert
+// a whole range, convert its first element and add the distance.
+template <typename Iterator>
+auto to_pointer(Iterator it) {return std::addressof(*it);}
+
+template <typename T>
+T* to_pointer(T* it) {return it;}
+
+}//namespace lex
+#endif// _contiguous_iterator_h_
@@ -0,0 +1,81 @@
+/*
+ * A sparse_set holds a subset of the integers [0, capacity).
+ *
+ * Insertion, membership and clear() are all O(1), and iteration visits the
+ * members in insertion order. All storage is allocated by the constructor,
+ * so a sparse_set can be cleared and refilled any number of times without
+ * touching the allocator. (See Briggs & Torczon, "An Efficient
+ * Representation for Sparse Sets".)
+ */
+#ifndef _sparse_set_h_
+#define _sparse_set_h_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace lex {
+
+template <typename Index = std::size_t>
+class sparse_set {
+ public:
+  using value_type = Index;
+  using size_type = std::size_t;
+  using const_iterator = typename std::vector<Index>::const_iterator;
+
+  sparse_set(): size_ {0} {}
+  explicit sparse_set(size_type capacity)
+    : dense(capacity),
+      sparse(capacity),
+      size_ {0} {}
+
+  bool empty() const {return size_ == 0;}
+  size_type size() const {return size_;}
+  size_type capacity() const {return dense.size();}
+
+  bool contains(value_type i) const;
+  // This returns false if i was already a member.
+  bool insert(value_type i);
+  void clear() {size_ = 0;}
+
+  value_type operator[](size_type n) const {return dense[n];}
+  const_iterator begin() const {return dense.begin();}
+  const_iterator end() const {return dense.begin() + size_;}
+
+  void swap(sparse_set& other);
+ private:
+  std::vector<Index> dense;
+  std::vector<Index> sparse;
+  size_type size_;
+};
+
+template <typename Index>
+bool sparse_set<Index>::contains(value_type i) const {
+  auto n = sparse[i];
+  return n < size_ && dense[n] == i;
+}
+
+template <typename Index>
+bool sparse_set<Index>::insert(value_type i) {
+  if (contains(i)) return false;
+  dense[size_] = i;
+  sparse[i] = static_cast<Index>(size_);
+  ++size_;
+  return true;
+}
+
+template <typename Index>
+void sparse_set<Index>::swap(sparse_set& other) {
+  using std::swap;
+  swap(dense, other.dense);
+  swap(sparse, other.sparse);
+  swap(size_, other.size_);
+}
+
+template <typename Index>
+void swap(sparse_set<Index>& left, sparse_set<Index>& right) {
+  left.swap(right);
+}
+
+}//namespace lex
+#endif// _sparse_set_h_
@@ -0,0 +1,119 @@
+/*
+ * A buffer_iterator walks through the characters of an input_buffer. It
+ * holds the absolute position of a character in the input rather than a
+ * pointer, so it stays valid when the buffer reads more input or grows,
+ * until the character is flushed.
+ *
+ * The end iterator of a buffer is a sentinel. Comparing an iterator with it
+ * reads more input if the iterator has caught up with what is loaded, so
+ * the end of the input is only detected when it is reached. Apart from
+ * comparison, the sentinel supports no operations. Since the distance to
+ * it is unknown, the iterator only claims to be a forward iterator, and
+ * standard algorithms never do arithmetic with the sentinel. Other
+ * iterators may still be moved, compared and subtracted directly within
+ * the loaded input, and a reference is only valid until the buffer next
+ * reads. An unqualified call to distance() finds the constant time
+ * overload below.
+ */
+
+#ifndef _buffer_iterator_h_
+#define _buffer_iterator_h_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+
+namespace lex {
+
+template <typename Buffer>
+class buffer_iterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename Buffer::value_type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const value_type*;
+  using reference = const value_type&;
+  using position_type = std::uint64_t;
+
+  buffer_iterator() = default;
+  buffer_iterator(Buffer* b, position_type p)
+    : buffer {b},
+      pos {p} {}
+
+  static buffer_iterator sentinel(Buffer* b) {
+    return buffer_iterator(b, end_position());
+  }
+
+  position_type position() const {return pos;}
+  bool is_sentinel() const {return pos == end_position();}
+
+  reference operator*() const {return buffer->at(pos);}
+  pointer operator->() const {return &buffer->at(pos);}
+  reference operator[](difference_type n) const {return buffer->at(pos + n);}
+
+  buffer_iterator& operator++() {++pos; return *this;}
+  buffer_iterator operator++(int) {auto copy = *this; ++pos; return copy;}
+  buffer_iterator& operator--() {--pos; return *this;}
+  buffer_iterator operator--(int) {auto copy = *this; --pos; return copy;}
+  buffer_iterator& operator+=(difference_type n) {pos += n; return *this;}
+  buffer_iterator& operator-=(difference_type n) {pos -= n; return *this;}
+
+  friend buffer_iterator operator+(buffer_iterator it, difference_type n) {
+    return it += n;
+  }
+  friend buffer_iterator operator+(difference_type n, buffer_iterator it) {
+    return it += n;
+  }
+  friend buffer_iterator operator-(buffer_iterator it, difference_type n) {
+    return it -= n;
+  }
+  friend difference_type operator-(const buffer_iterator& a,
+      const buffer_iterator& b) {
+    return static_cast<difference_type>(a.pos - b.pos);
+  }
+  // Pre: Neither iterator is the sentinel.
+  friend difference_type distance(const buffer_iterator& first,
+      const buffer_iterator& last) {
+    return last - first;
+  }
+
+  friend bool operator==(const buffer_iterator& a,
+      const buffer_iterator& b) {
+    if (a.is_sentinel() || b.is_sentinel()) {
+      return a.at_end() && b.at_end();
+    }
+    return a.pos == b.pos;
+  }
+  friend bool operator!=(const buffer_iterator& a,
+      const buffer_iterator& b) {
+    return !(a == b);
+  }
+  friend bool operator<(const buffer_iterator& a, const buffer_iterator& b) {
+    return a.pos < b.pos;
+  }
+  friend bool operator>(const buffer_iterator& a, const buffer_iterator& b) {
+    return b < a;
+  }
+  friend bool operator<=(const buffer_iterator& a,
+      const buffer_iterator& b) {
+    return !(b < a);
+  }
+  friend bool operator>=(const buffer_iterator& a,
+      const buffer_iterator& b) {
+    return !(a < b);
+  }
+ private:
+  Buffer* buffer {nullptr};
+  position_type pos {0};
+
+  static position_type end_position() {
+    return std::numeric_limits<position_type>::max();
+  }
+  bool at_end() const {
+    return is_sentinel() || !buffer || buffer->exhausted(pos);
+  }
+};
+
+}//namespace lex
+#endif// _buffer_iterator_h_
@@ -0,0 +1,228 @@
+/*
+ * An input_buffer holds the input a lexer has read but not yet consumed.
+ * Its storage is a ring whose size is a power of two, so a character at
+ * absolute position p lives at index p & (capacity - 1). Reading appends
+ * at the tail, and flush() just moves the head, so it takes constant time
+ * and never moves any characters.
+ *
+ * Input is read in blocks, as much as fits in the free part of the ring.
+ * The ring only grows, doubling, when it is full, that is when a single
+ * token is longer than the whole ring.
+ *
+ * The input may come from
+ *   a range of iterators. Forward iterators are copied a block at a time.
+ *   Single pass input iterators are read one character at a time, since a
+ *   block read could wait on interactive input for characters the lexer
+ *   does not yet need.
+ *   a std::basic_streambuf, through sgetn(). Only the characters the
+ *   stream already holds are taken, so interactive input stays responsive.
+ *   a file descriptor, through read(2). A read interrupted by a signal is
+ *   retried. Any other error, EAGAIN included, throws a std::system_error
+ *   rather than ending the input early.
+ * The stream or file descriptor must outlive the buffer, and the buffer
+ * does not close it.
+ */
+
+#ifndef _input_buffer_h_
+#define _input_buffer_h_
+
+#include "iterator_adapter/buffer_iterator.h"
+#include "regex_types.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <streambuf>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace lex {
+
+// This distinguishes a file descriptor from other integers.
+struct file_descriptor {
+  int fd;
+};
+
+template <typename InputIter>
+class input_buffer {
+ public:
+  using value_type = char_type_t<InputIter>;
+  using size_type = std::size_t;
+  using position_type = std::uint64_t;
+  using iterator = buffer_iterator<input_buffer>;
+  // A reader copies up to n characters to dest and returns how many it
+  // copied. It returns 0 only at the end of the input.
+  using reader_type = std::function<size_type(value_type* dest, size_type n)>;
+
+  static size_type default_capacity() {return 1 << 16;}
+
+  // The capacity is rounded up to a power of two.
+  input_buffer(InputIter begin, InputIter end,
+      size_type capacity = default_capacity())
+    : input_buffer(make_reader(begin, end,
+          typename std::iterator_traits<InputIter>::iterator_category{}),
+        capacity) {}
+  explicit input_buffer(std::basic_streambuf<value_type>& source,
+      size_type capacity = default_capacity())
+    : input_buffer(stream_reader(source), capacity) {}
+  explicit input_buffer(file_descriptor source,
+      size_type capacity = default_capacity())
+    : input_buffer(descriptor_reader(source), capacity) {}
+  input_buffer(reader_type reader, size_type capacity);
+
+  input_buffer(const input_buffer&) = delete;
+  input_buffer& operator=(const input_buffer&) = delete;
+
+  iterator begin() {return iterator(this, head);}
+  iterator end() {return iterator::sentinel(this);}
+
+  // This discards everything before it.
+  void flush(iterator it) {head = it.position();}
+
+  size_type capacity() const {return data.size();}
+  // The number of characters read but not flushed.
+  size_type size() const {return static_cast<size_type>(tail - head);}
+
+  // The position must be loaded, i.e. in [head, tail).
+  const value_type& at(position_type pos) const {return data[pos & mask];}
+  // This reads more input if pos is the tail. It returns true if there is
+  // still no character at pos.
+  bool exhausted(position_type pos) {return pos >= tail && !fill();}
+ private:
+  reader_type read;
+  std::vector<value_type> data;
+  position_type mask;
+  position_type head {0};
+  position_type tail {0};
+  bool eof {false};
+
+  bool fill();
+  void grow();
+
+  template <typename Iter>
+  static reader_type make_reader(Iter begin, Iter end,
+      std::input_iterator_tag);
+  template <typename Iter>
+  static reader_type make_reader(Iter begin, Iter end,
+      std::forward_iterator_tag);
+  static reader_type stream_reader(std::basic_streambuf<value_type>& source);
+  static reader_type descriptor_reader(file_descriptor source);
+};
+
+template <typename InputIter>
+input_buffer<InputIter>::input_buffer(reader_type reader,
+    size_type capacity)
+  : read {std::move(reader)} {
+  size_type size {1};
+  while (size < capacity) {
+    size <<= 1;
+  }
+  data.resize(size);
+  mask = size - 1;
+}
+
+// Only the free part of the ring after the tail, up to the end of the
+// storage, is filled in one read. The next read wraps around.
+template <typename InputIter>
+bool input_buffer<InputIter>::fill() {
+  if (eof) {
+    return false;
+  }
+  if (size() == capacity()) {
+    grow();
+  }
+  auto start = static_cast<size_type>(tail & mask);
+  auto room = std::min(capacity() - start, capacity() - size());
+  auto count = read(data.data() + start, room);
+  if (count == 0) {
+    eof = true;
+    return false;
+  }
+  tail += count;
+  return true;
+}
+
+template <typename InputIter>
+void input_buffer<InputIter>::grow() {
+  std::vector<value_type> larger(2 * data.size());
+  position_type larger_mask = larger.size() - 1;
+  for (auto pos = head; pos != tail; ++pos) {
+    larger[pos & larger_mask] = data[pos & mask];
+  }
+  data.swap(larger);
+  mask = larger_mask;
+}
+
+template <typename InputIter>
+template <typename Iter>
+typename input_buffer<InputIter>::reader_type
+input_buffer<InputIter>::make_reader(Iter begin, Iter end,
+    std::input_iterator_tag) {
+  return [begin, end] (value_type* dest, size_type) mutable -> size_type {
+    if (begin == end) {
+      return 0;
+    }
+    *dest = *begin;
+    ++begin;
+    return 1;
+  };
+}
+
+template <typename InputIter>
+template <typename Iter>
+typename input_buffer<InputIter>::reader_type
+input_buffer<InputIter>::make_reader(Iter begin, Iter end,
+    std::forward_iterator_tag) {
+  return [begin, end] (value_type* dest, size_type n) mutable -> size_type {
+    size_type count {0};
+    for (; count < n && begin != end; ++count, ++begin) {
+      dest[count] = *begin;
+    }
+    return count;
+  };
+}
+
+template <typename InputIter>
+typename input_buffer<InputIter>::reader_type
+input_buffer<InputIter>::stream_reader(
+    std::basic_streambuf<value_type>& source) {
+  auto stream = &source;
+  return [stream] (value_type* dest, size_type n) -> size_type {
+    // Taking one character makes the stream read what it can.
+    std::streamsize count {1};
+    auto available = stream->in_avail();
+    if (available > 0) {
+      count = std::min<std::streamsize>(available, n);
+    }
+    auto got = stream->sgetn(dest, count);
+    return got > 0? static_cast<size_type>(got) : 0;
+  };
+}
+
+template <typename InputIter>
+typename input_buffer<InputIter>::reader_type
+input_buffer<InputIter>::descriptor_reader(file_descriptor source) {
+  static_assert(sizeof(value_type) == 1,
+      "A file descriptor can only be read as bytes.");
+  return [source] (value_type* dest, size_type n) -> size_type {
+    while (true) {
+      auto got = ::read(source.fd, dest, n);
+      if (got >= 0) {
+        return static_cast<size_type>(got);
+      }
+      if (errno != EINTR) {
+        throw std::system_error(errno, std::generic_category());
+      }
+    }
+  };
+}
+
+}//namespace lex
+#endif// _input_buffer_h_
@@ -0,0 +1,106 @@
+/*
+ * A mapped_source maps a whole file into memory read only, so it can be
+ * lexed in place as one contiguous range of chars. The kernel is told that
+ * the mapping will be read sequentially, so it reads ahead aggressively and
+ * drops pages behind the reader.
+ *
+ * An empty file is an empty range and needs no mapping.
+ */
+
+#ifndef _mapped_source_h_
+#define _mapped_source_h_
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lex {
+
+class mapped_source {
+ public:
+  mapped_source() = default;
+  explicit mapped_source(const std::string& path) {open(path);}
+  mapped_source(const mapped_source&) = delete;
+  mapped_source& operator=(const mapped_source&) = delete;
+  mapped_source(mapped_source&& other) {*this = std::move(other);}
+  mapped_source& operator=(mapped_source&& other);
+  ~mapped_source() {close();}
+
+  // On failure the source is left closed and error() holds the errno
+  // value.
+  bool open(const std::string& path);
+  void close();
+
+  bool is_open() const {return open_;}
+  int error() const {return error_;}
+
+  const char* begin() const {return address;}
+  const char* end() const {return address + length;}
+  const char* data() const {return address;}
+  std::size_t size() const {return length;}
+ private:
+  const char* address {nullptr};
+  std::size_t length {0};
+  bool open_ {false};
+  int error_ {0};
+};
+
+inline mapped_source& mapped_source::operator=(mapped_source&& other) {
+  if (this != &other) {
+    close();
+    std::swap(address, other.address);
+    std::swap(length, other.length);
+    std::swap(open_, other.open_);
+    std::swap(error_, other.error_);
+  }
+  return *this;
+}
+
+inline bool mapped_source::open(const std::string& path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error_ = errno;
+    return false;
+  }
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    error_ = errno;
+    ::close(fd);
+    return false;
+  }
+  if (info.st_size > 0) {
+    void* p = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      error_ = errno;
+      ::close(fd);
+      return false;
+    }
+    // This is only advice, so a failure is harmless.
+    ::madvise(p, info.st_size, MADV_SEQUENTIAL);
+    address = static_cast<const char*>(p);
+    length = info.st_size;
+  }
+  ::close(fd);
+  open_ = true;
+  error_ = 0;
+  return true;
+}
+
+inline void mapped_source::close() {
+  if (address) {
+    ::munmap(const_cast<char*>(address), length);
+  }
+  address = nullptr;
+  length = 0;
+  open_ = false;
+}
+
+}//namespace lex
+#endif// _mapped_source_h_
@@ -0,0 +1,48 @@
+/*
+ * A range_buffer is the buffer of a lexer whose input is already in memory
+ * and may be read more than once, i.e. a range of forward iterators. It
+ * copies nothing: its iterators are the input's own iterators, and flush()
+ * just moves the start of the range. Over contiguous input, such as a
+ * mapped_source, tokens are therefore plain pointer ranges into the input.
+ *
+ * The buffer may share ownership of whatever holds the input, so that the
+ * input lives as long as the buffer.
+ */
+
+#ifndef _range_buffer_h_
+#define _range_buffer_h_
+
+#include "regex_types.h"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace lex {
+
+template <typename ForwardIt>
+class range_buffer {
+ public:
+  using value_type = char_type_t<ForwardIt>;
+  using iterator = ForwardIt;
+
+  range_buffer(ForwardIt begin, ForwardIt end,
+      std::shared_ptr<const void> owner = nullptr)
+    : first {begin},
+      last {end},
+      input {std::move(owner)} {}
+
+  iterator begin() const {return first;}
+  iterator end() const {return last;}
+
+  // This discards everything before it.
+  void flush(iterator it) {first = it;}
+ private:
+  ForwardIt first;
+  ForwardIt last;
+  std::shared_ptr<const void> input;
+};
+
+}//namespace lex
+#endif// _range_buffer_h_
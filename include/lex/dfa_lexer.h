@@ -0,0 +1,126 @@
+/*
+ * A dfa_lexer runs a dfa with one action per rule, usually one saved with
+ * automaton/dfa_file.h. Nothing is compiled when it is constructed, so a
+ * process that finds the dfa of its rules in a dfa_cache starts lexing
+ * without building a single regex. load_rules() looks the rules up in a
+ * cache and only compiles them, once, when they are missing.
+ *
+ * The dfa runs over single byte characters. As in a lexer, the longest
+ * match wins, among matches of the same length the earliest rule wins, and
+ * empty matches are never accepted. Actions see their token in place.
+ */
+
+#ifndef _dfa_lexer_h_
+#define _dfa_lexer_h_
+
+#include "automaton/dfa.h"
+#include "automaton/dfa_file.h"
+#include "automaton/program.h"
+#include "lex/token_view.h"
+#include "regex/regex.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <locale>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace lex {
+
+template <typename ForwardIt>
+class dfa_lexer {
+ public:
+  using char_type = typename std::iterator_traits<ForwardIt>::value_type;
+  using token_type = token_view<ForwardIt>;
+  using function_type = std::function<void(token_type)>;
+
+  // Rule r of the dfa calls actions[r]. The table is a mapped_dfa, a
+  // cached_dfa or a dfa, and the lexer keeps it alive. Lexers constructed
+  // from the same pointer share one table. A std::invalid_argument is
+  // thrown if there is no dfa or it has a rule without an action.
+  template <typename Owner>
+  dfa_lexer(ForwardIt begin, ForwardIt end, std::shared_ptr<Owner> table,
+      std::vector<function_type> actions);
+
+  // This matches one token and calls the action of its rule on it. It
+  // returns false, calling no action, at the end of the input or at input
+  // that matches no rule.
+  bool lex();
+
+  // The number of characters lexed so far.
+  std::uint64_t position() const {return consumed;}
+ private:
+  ForwardIt current;
+  ForwardIt last;
+  std::shared_ptr<const void> owner;
+  std::vector<function_type> actions;
+  dfa_engine engine;
+  std::uint64_t consumed {0};
+};
+
+template <typename ForwardIt>
+template <typename Owner>
+dfa_lexer<ForwardIt>::dfa_lexer(ForwardIt begin, ForwardIt end,
+    std::shared_ptr<Owner> table, std::vector<function_type> acts)
+  : current {begin},
+    last {end},
+    owner {table},
+    actions {std::move(acts)},
+    engine {table? table->view() : dfa_view()} {
+  static_assert(sizeof(char_type) == 1,
+      "A dfa_lexer needs single byte characters.");
+  auto view = table? table->view() : dfa_view();
+  if (view.state_count() == 0) {
+    throw std::invalid_argument("dfa_lexer: there is no dfa");
+  }
+  for (std::size_t s = 0; s != view.state_count(); ++s) {
+    auto rule = view.rule(static_cast<dfa_view::state_type>(s));
+    if (rule != dfa_view::no_rule() && rule >= actions.size()) {
+      throw std::invalid_argument("dfa_lexer: a rule has no action");
+    }
+  }
+}
+
+template <typename ForwardIt>
+bool dfa_lexer<ForwardIt>::lex() {
+  std::size_t rule;
+  auto token_end = engine.match(current, last, rule);
+  if (rule == thread_flags::no_rule()) return false;
+  actions[rule](token_type(current, token_end));
+  consumed += std::distance(current, token_end);
+  current = token_end;
+  return true;
+}
+
+// This maps the dfa of the rules, a range of std::string patterns, from
+// the cache. Only if the cache has no dfa for them are they compiled, with
+// the given flags in the global locale, joined as a translator joins them,
+// and saved. If saving fails the dfa is lexed from memory. Null is
+// returned if the dfa can neither be loaded nor built.
+template <typename Iterator>
+std::shared_ptr<const cached_dfa> load_rules(const dfa_cache& cache,
+    Iterator begin, Iterator end,
+    regex_constants::syntax_option_type flags = regex<char>::default_flag) {
+  auto key = rule_set_hash(begin, end, flags, std::locale());
+  auto build = [begin, end, flags] () {
+    program_builder<char, regex<char>::traits_type> builder;
+    std::size_t rule {0};
+    for (auto it = begin; it != end; ++it, ++rule) {
+      regex<char> reg(*it, flags);
+      builder.append_rule(reg.get_program(), rule, std::next(it) == end);
+    }
+    return build_dfa(builder.release());
+  };
+  auto table = std::make_shared<cached_dfa>();
+  if (begin == end || !cache.load(key, *table, build)) {
+    return nullptr;
+  }
+  return table;
+}
+
+}//namespace lex
+#endif// _dfa_lexer_h_
@@ -0,0 +1,236 @@
+/*
+ * An incremental_lexer keeps a text together with its list of tokens and
+ * keeps the list up to date as the text is edited, which is what an editor
+ * or a language server needs. No actions are run; the tokens are only
+ * recorded.
+ *
+ * Between tokens the lexer has no state other than its position, so every
+ * token boundary is a checkpoint from which lexing may restart. An edit
+ * can only change a token whose match read some of the edited text, so
+ * each token also records how many characters its match read, including
+ * those read past its end. Lexing restarts at the first token that read
+ * into the edit, and stops as soon as it reaches the start of an old token
+ * after the edit. From there on the old tokens are kept, only moved. The
+ * lexing done for an edit is therefore proportional to the size of the
+ * edit, not of the text.
+ */
+
+#ifndef _incremental_lexer_h_
+#define _incremental_lexer_h_
+
+#include "automaton/lazy_dfa.h"
+#include "automaton/literal_trie.h"
+#include "lex/lexer_impl.h"
+#include "lex/token_view.h"
+#include "lex/translator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lex {
+
+struct incremental_token {
+  std::size_t rule;
+  std::size_t offset;
+  std::size_t length;
+  // The number of characters the match read, at least length. One more
+  // than the rest of the text means it would have read further.
+  std::size_t scanned;
+};
+
+// An edit replaced the tokens [first, first + removed) with inserted new
+// ones.
+struct token_change {
+  std::size_t first;
+  std::size_t removed;
+  std::size_t inserted;
+};
+
+template <typename CharT, typename Traits = std::regex_traits<CharT>>
+class incremental_lexer {
+ public:
+  using char_type = CharT;
+  using string_type = typename Traits::string_type;
+  using token_type = token_view<const char_type*>;
+  // The actions of the translator are never called, so they may be empty.
+  using function_type = std::function<void(token_type)>;
+  using translator_type = translator<incremental_lexer>;
+  using translator_item = std::pair<string_type, function_type>;
+  using token_list = std::vector<incremental_token>;
+
+  explicit incremental_lexer(std::shared_ptr<const translator_type> translator,
+      string_type text = string_type());
+
+  const string_type& text() const {return text_;}
+  const token_list& tokens() const {return tokens_;}
+  // The text from here on matches no rule. This is the size of the text
+  // if all of it was lexed.
+  std::size_t lexed() const {return lexed_;}
+  token_type view(const incremental_token& t) const {
+    return token_type(text_.data() + t.offset,
+        text_.data() + t.offset + t.length);
+  }
+
+  // This replaces removed characters at offset with inserted. As with
+  // std::basic_string::replace, removed may run past the end of the text,
+  // and std::out_of_range is thrown if offset does.
+  token_change edit(std::size_t offset, std::size_t removed,
+      const string_type& inserted);
+  token_change assign(string_type text);
+ private:
+  using engine_type = lazy_dfa<char_type, Traits>;
+  using keyword_type = typename translator_type::keyword_type;
+  using keyword_engine_type = literal_trie_engine<char_type>;
+
+  std::shared_ptr<const translator_type> trans;
+  std::shared_ptr<const keyword_type> keywords;
+  engine_type engine;
+  keyword_engine_type keyword_engine;
+
+  string_type text_;
+  token_list tokens_;
+  std::size_t lexed_ {0};
+  // No token read more than this, so lexing never needs to restart more
+  // than this far before an edit.
+  std::size_t max_scanned {0};
+
+  bool match(std::size_t pos, incremental_token& t);
+};
+
+template <typename CharT, typename Traits>
+incremental_lexer<CharT,Traits>::incremental_lexer(
+    std::shared_ptr<const translator_type> translator, string_type text)
+  : trans {std::move(translator)},
+    keywords {trans->get_keywords()},
+    engine {trans->get_patterns()},
+    keyword_engine {*keywords} {
+  assign(std::move(text));
+}
+
+// The match is longest first, then earliest rule, as in the lexer.
+template <typename CharT, typename Traits>
+bool incremental_lexer<CharT,Traits>::match(std::size_t pos,
+    incremental_token& t) {
+  engine.initialize();
+  keyword_engine.initialize();
+  bool pattern_live {engine.state() != match_state::MISMATCH};
+  bool keyword_live {keyword_engine.state() != match_state::MISMATCH};
+  auto rule = thread_flags::no_rule();
+  std::size_t accepted {0};
+  std::size_t seek {pos};
+  for (; (pattern_live || keyword_live) && seek != text_.size(); ++seek) {
+    auto matched = thread_flags::no_rule();
+    if (pattern_live) {
+      detail::advance_engine(engine, text_[seek], pattern_live, matched);
+    }
+    if (keyword_live) {
+      detail::advance_engine(keyword_engine, text_[seek], keyword_live,
+          matched);
+    }
+    if (matched != thread_flags::no_rule()) {
+      accepted = seek + 1 - pos;
+      rule = matched;
+    }
+  }
+  bool live {pattern_live || keyword_live};
+  t = incremental_token {rule, pos, accepted, seek - pos + (live? 1 : 0)};
+  return rule != thread_flags::no_rule();
+}
+
+template <typename CharT, typename Traits>
+token_change incremental_lexer<CharT,Traits>::assign(string_type text) {
+  text_ = std::move(text);
+  auto removed = tokens_.size();
+  tokens_.clear();
+  max_scanned = 0;
+  std::size_t pos {0};
+  incremental_token t;
+  while (pos != text_.size() && match(pos, t)) {
+    tokens_.push_back(t);
+    max_scanned = std::max(max_scanned, t.scanned);
+    pos += t.length;
+  }
+  lexed_ = pos;
+  return token_change {0, removed, tokens_.size()};
+}
+
+template <typename CharT, typename Traits>
+token_change incremental_lexer<CharT,Traits>::edit(std::size_t offset,
+    std::size_t removed, const string_type& inserted) {
+  if (offset > text_.size()) {
+    throw std::out_of_range("incremental_lexer::edit");
+  }
+  removed = std::min(removed, text_.size() - offset);
+  auto edit_end = offset + removed;
+  auto by_offset = [] (const incremental_token& t, std::size_t o) {
+    return t.offset < o;
+  };
+
+  // The first token to lex again is the first that read into the edit.
+  // Only tokens that start less than max_scanned before it need checking.
+  auto at_edit = std::lower_bound(tokens_.begin(), tokens_.end(), offset,
+      by_offset);
+  auto first = at_edit;
+  while (first != tokens_.begin() &&
+      std::prev(first)->offset + max_scanned > offset) {
+    --first;
+  }
+  while (first != at_edit && first->offset + first->scanned <= offset) {
+    ++first;
+  }
+  auto restart = first == tokens_.end()? lexed_ : first->offset;
+
+  // Old tokens after the edit are where lexing may fall back into step.
+  auto old_lexed = lexed_;
+  auto shift = [&] (std::size_t o) {return o - removed + inserted.size();};
+  auto sync = std::lower_bound(first, tokens_.end(), edit_end, by_offset);
+  text_.replace(offset, removed, inserted);
+
+  token_list fresh;
+  auto pos = restart;
+  bool synced {false};
+  incremental_token t;
+  while (true) {
+    while (sync != tokens_.end() && shift(sync->offset) < pos) {
+      ++sync;
+    }
+    if (sync != tokens_.end() && shift(sync->offset) == pos) {
+      synced = true;
+      break;
+    }
+    // Input that matched no rule before still does.
+    if (sync == tokens_.end() && old_lexed >= edit_end &&
+        shift(old_lexed) == pos) {
+      synced = true;
+      break;
+    }
+    if (pos == text_.size() || !match(pos, t)) {
+      break;
+    }
+    fresh.push_back(t);
+    max_scanned = std::max(max_scanned, t.scanned);
+    pos += t.length;
+  }
+  if (!synced) {
+    sync = tokens_.end();
+  }
+
+  for (auto it = sync; it != tokens_.end(); ++it) {
+    it->offset = shift(it->offset);
+  }
+  token_change change {static_cast<std::size_t>(first - tokens_.begin()),
+    static_cast<std::size_t>(sync - first), fresh.size()};
+  tokens_.insert(tokens_.erase(first, sync), fresh.begin(), fresh.end());
+  lexed_ = synced? shift(old_lexed) : pos;
+  return change;
+}
+
+}//namespace lex
+#endif// _incremental_lexer_h_
@@ -5,6 +5,7 @@
 #include "iterator_adapter/buffer_iterator.h"
 #include "lex/translator.h"
 #include "lex/lexer_impl.h"
+#include "lex/token_view.h"
 
 #include <cstddef>
 #include <iterator>
@@ -27,10 +28,14 @@ class iterator_adapter {
   using buffer_type = input_buffer<InputIter>;
   using char_type = typename std::iterator_traits<InputIter>::value_type;
   using string_type = std::basic_string<char_type>;
-  using function_type = std::function<value_type(const string_type&)>;
+  // As with a lexer, an action may take either the token_type or a
+  // const string_type&, which makes a copy.
+  using token_type = token_view<typename buffer_type::iterator>;
+  using function_type = std::function<value_type(token_type)>;
 
+  // The translator is only read, so it may be shared by many adapters.
   iterator_adapter(InputIter begin, InputIter end, 
-      translator<iterator_adapter>* table); 
+      const translator<iterator_adapter>* table); 
   iterator_adapter() 
     : buffer_p {nullptr},
       trans_p {nullptr},
@@ -54,7 +59,7 @@ class iterator_adapter {
   iterator_adapter operator++(int);
  private:
   std::shared_ptr<buffer_type> buffer_p;
-  translator<iterator_adapter>* trans_p;
+  const translator<iterator_adapter>* trans_p;
   lexer_impl<iterator_adapter> lex_impl;
 
   size_t index;
@@ -69,7 +74,7 @@ class iterator_adapter {
 
 template <typename InputIter, typename T>
 iterator_adapter<InputIter,T>::iterator_adapter(
-    InputIter begin, InputIter end, translator<iterator_adapter>* ptr) 
+    InputIter begin, InputIter end, const translator<iterator_adapter>* ptr) 
   : buffer_p {std::make_shared<buffer_type>(begin, end)},
     trans_p {ptr},
     lex_impl(buffer_p.get(), trans_p),
@@ -134,11 +139,9 @@ bool iterator_adapter<InputIter,T>::lex() {
     return false;
   }
 
-  // We form a string from the matching input.
+  // The action sees the matching input where it lies in the buffer.
   auto buff_it = result.first;
-  auto string_result = string_type(buffer_p->begin(), buff_it);
-  // Now we call the function corresponding to the matched regex.
-  current = (trans_it->second)(string_result);
+  current = (trans_it->second)(token_type(buffer_p->begin(), buff_it));
   // We flush the processed input from the buffer.
   buffer_p->flush(buff_it);
   return true;
@@ -3,32 +3,71 @@
 
 #include "lex/lexer_impl.h"
 #include "iterator_adapter/input_buffer.h"
+#include "iterator_adapter/mapped_source.h"
+#include "iterator_adapter/range_buffer.h"
+#include "lex/token_batch.h"
+#include "lex/token_view.h"
 #include "lex/translator.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
+#include <limits>
 #include <memory>
+#include <stdexcept>
+#include <streambuf>
 #include <string>
+#include <system_error>
+#include <type_traits>
 #include <utility>
 
 namespace lex {
 
+// Input that can be read more than once is lexed where it lies, through a
+// range_buffer. Single pass input, streams and file descriptors are read
+// into an input_buffer.
 template <typename InputIter, 
           typename Traits = std::regex_traits<char_type_t<InputIter>>
          >
 class lexer {
  public:
-  using buffer_type = input_buffer<InputIter>;
+  using buffer_type = std::conditional_t<
+    std::is_base_of<std::forward_iterator_tag, 
+      typename std::iterator_traits<InputIter>::iterator_category>::value,
+    range_buffer<InputIter>, input_buffer<InputIter>>;
   using char_type = char_type_t<InputIter>;
   using string_type = typename Traits::string_type;
-  using function_type = std::function<void(const string_type&)>;
+  // An action sees its token in place in the buffer. An action taking a
+  // const string_type& is also accepted; it gets a copy.
+  using token_type = token_view<typename buffer_type::iterator>;
+  using function_type = std::function<void(token_type)>;
   using translator_type = translator<lexer>;
   using translator_item = std::pair<string_type, function_type>;
 
   lexer(InputIter begin, InputIter end, 
         const translator_type& translator) 
-    : buffer_p {std::make_unique<buffer_type>(begin, end)},
-      trans {translator},
-      lex_impl(buffer_p.get(), trans) {}
+    : lexer(begin, end, std::make_shared<const translator_type>(translator)) {}
+  // Lexers constructed from the same pointer share one compiled rule set.
+  lexer(InputIter begin, InputIter end, 
+        std::shared_ptr<const translator_type> translator) 
+    : lexer(std::make_unique<buffer_type>(begin, end), std::move(translator))
+  {}
+  // These read their input in blocks straight from a stream buffer or a
+  // file descriptor, which must outlive the lexer. They are only available
+  // for single pass InputIter types.
+  lexer(std::basic_streambuf<char_type>& source,
+        std::shared_ptr<const translator_type> translator) 
+    : lexer(std::make_unique<buffer_type>(source), std::move(translator)) {}
+  lexer(file_descriptor source,
+        std::shared_ptr<const translator_type> translator) 
+    : lexer(std::make_unique<buffer_type>(source), std::move(translator)) {}
+
+  // This maps a whole file into memory and lexes it in place. InputIter
+  // must be const char*. A std::system_error is thrown if the file
+  // cannot be mapped.
+  static lexer from_file(const std::string& path,
+      std::shared_ptr<const translator_type> translator);
 
   lexer(const lexer&) = delete;
   lexer& operator=(const lexer&) = delete;
@@ -38,33 +77,128 @@ class lexer {
 
   bool lex();
 
+  // These lex up to count tokens without calling their actions and return
+  // the number lexed. They stop early at the end of the input, at input
+  // that matches no rule, or when an offset would not fit in 32 bits; that
+  // token starts the next batch. A token whose length does not fit in 32
+  // bits can start no batch, so a std::length_error is thrown for it
+  // instead. It is left unread, and lex() can still take it.
+  std::size_t lex_batch(token_record* records, std::size_t count);
+  // The columns are cleared first.
+  std::size_t lex_into(token_columns& columns, std::size_t count);
+
+  // The number of characters lexed so far.
+  std::uint64_t position() const {return consumed;}
+
   template <typename Container, 
             typename = enable_container_t<Container, translator_item>>
   void set_translator(Container&& c) {
-    trans = translator_type(c.begin(), c.end());
+    trans = std::make_shared<const translator_type>(c.begin(), c.end());
+    lex_impl = lexer_impl<lexer>(buffer_p.get(), trans.get());
   }
 
  private:
+  lexer(std::unique_ptr<buffer_type> buffer, 
+        std::shared_ptr<const translator_type> translator) 
+    : buffer_p {std::move(buffer)},
+      trans {std::move(translator)},
+      lex_impl(buffer_p.get(), trans.get()) {}
+
   std::unique_ptr<buffer_type> buffer_p;
-  translator_type trans;
+  std::shared_ptr<const translator_type> trans;
   lexer_impl<lexer> lex_impl;
+  std::uint64_t consumed {0};
+
+  template <typename Emit>
+  std::size_t lex_tokens(std::size_t count, Emit emit);
 };
 
+template <typename InputIter, typename Traits>
+lexer<InputIter,Traits> lexer<InputIter,Traits>::from_file(
+    const std::string& path, 
+    std::shared_ptr<const translator_type> translator) {
+  static_assert(std::is_same<InputIter, const char*>::value,
+      "from_file() needs a lexer over const char*.");
+  auto source = std::make_shared<mapped_source>();
+  if (!source->open(path)) {
+    throw std::system_error(source->error(), std::generic_category(), path);
+  }
+  auto begin = source->begin();
+  auto end = source->end();
+  return lexer(std::make_unique<buffer_type>(begin, end, std::move(source)),
+      std::move(translator));
+}
+
 template <typename InputIter, typename Traits>
 bool lexer<InputIter,Traits>::lex() {
   auto result = lex_impl.do_lex();
   auto trans_it = result.second;
   // We check for a failed read.
-  if (trans_it == trans.end()) return false;
-  // We form a string from the matching input.
+  if (trans_it == trans->end()) return false;
+  // The action sees the matching input where it lies in the buffer.
   auto buff_it = result.first;
-  auto string_result = string_type(buffer_p->begin(), buff_it);
-  // Now we call the function corresponding to the matched regex.
-  (trans_it->second)(string_result);
+  (trans_it->second)(token_type(buffer_p->begin(), buff_it));
+  using std::distance;
+  consumed += distance(buffer_p->begin(), buff_it);
   // We flush the processed input from the buffer.
   buffer_p->flush(buff_it);
   return true;
 }
 
+// The emitter is called directly for each token, so it can be inlined.
+template <typename InputIter, typename Traits>
+template <typename Emit>
+std::size_t lexer<InputIter,Traits>::lex_tokens(std::size_t count, 
+    Emit emit) {
+  const std::uint64_t limit = std::numeric_limits<std::uint32_t>::max();
+  const auto base = consumed;
+  std::size_t lexed {0};
+  using std::distance;
+  while (lexed < count) {
+    auto result = lex_impl.do_lex();
+    if (result.second == trans->end()) break;
+    std::uint64_t length = distance(buffer_p->begin(), result.first);
+    std::uint64_t offset = consumed - base;
+    if (offset + length > limit) {
+      if (lexed == 0) {
+        throw std::length_error("lexer: token longer than 2^32-1 characters");
+      }
+      // The token stays in the buffer for the next batch.
+      break;
+    }
+    emit(static_cast<std::uint32_t>(result.second - trans->begin()),
+        static_cast<std::uint32_t>(offset), 
+        static_cast<std::uint32_t>(length));
+    consumed += length;
+    buffer_p->flush(result.first);
+    ++lexed;
+  }
+  return lexed;
+}
+
+template <typename InputIter, typename Traits>
+std::size_t lexer<InputIter,Traits>::lex_batch(token_record* records,
+    std::size_t count) {
+  return lex_tokens(count, [records] (std::uint32_t rule, 
+        std::uint32_t offset, std::uint32_t length) mutable {
+      *records++ = token_record {rule, offset, length};
+    });
+}
+
+template <typename InputIter, typename Traits>
+std::size_t lexer<InputIter,Traits>::lex_into(token_columns& columns,
+    std::size_t count) {
+  // The count may be a large bound rather than an expected size, so at
+  // most one ordinary batch is reserved up front.
+  const std::size_t batch = 4096;
+  columns.clear();
+  columns.reserve(std::min(count, batch));
+  columns.base = consumed;
+  return lex_tokens(count, [&columns] (std::uint32_t rule, 
+        std::uint32_t offset, std::uint32_t length) {
+      columns.push_back(rule, offset, length);
+    });
+}
+
 }//namespace lex
 #endif// _lexer_alt_h_
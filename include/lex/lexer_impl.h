@@ -1,15 +1,45 @@
 #ifndef _lexer_impl_h_
 #define _lexer_impl_h_
 
+#include "automaton/lazy_dfa.h"
+#include "automaton/literal_trie.h"
+#include "data_structures/contiguous_iterator.h"
 #include "iterator_adapter/buffer_iterator.h"
-#include "matcher/matcher.h"
 #include "lex/translator.h"
 
 #include "project_assert.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 namespace lex {
+namespace detail {
+
+// This steps one engine and lowers rule to the rule it matches, if any.
+// live is cleared once the engine can match nothing longer.
+template <typename Engine, typename CharT>
+void advance_engine(Engine& e, CharT ch, bool& live, std::size_t& rule) {
+  e.update(ch);
+  switch (e.state()) {
+  case match_state::MATCH:
+    rule = std::min(rule, e.rule());
+    break;
+  case match_state::FINAL_MATCH:
+    rule = std::min(rule, e.rule());
+    live = false;
+    break;
+  case match_state::MISMATCH:
+    live = false;
+    break;
+  case match_state::UNDECIDED:
+    break;
+  }
+}
+
+}//namespace detail
 
 template <typename L>
 class lexer_impl {
@@ -17,72 +47,112 @@ class lexer_impl {
   using buffer_type = typename L::buffer_type;
   using function_type = typename L::function_type;
   using char_type = typename buffer_type::value_type;
-  using regex_type = matcher<char_type>;
   using translator_type = translator<L>;
+  using regex_type = typename translator_type::regex_type;
+  using program_type = typename translator_type::program_type;
+  using engine_type = lazy_dfa<char_type, typename regex_type::traits_type>;
+  using keyword_type = typename translator_type::keyword_type;
+  using keyword_engine_type = literal_trie_engine<char_type>;
 
+  // The translator is only read, so many lexer_impl objects may share one.
+  // Each of them owns its own engine.
   lexer_impl(buffer_type* buff_ptr, 
-      translator_type* ptr) 
+      const translator_type* ptr) 
     : buffer {buff_ptr},
-      trans {ptr} {}
+      trans {ptr},
+      keywords {ptr? ptr->get_keywords() : 
+                     std::make_shared<const keyword_type>()},
+      engine {ptr? ptr->get_patterns() : 
+                   std::make_shared<const program_type>()},
+      keyword_engine {*keywords} {}
 
+  // The keyword engine points into the trie, which is shared, so copies
+  // may keep pointing to it.
   lexer_impl(const lexer_impl&) = default;
   lexer_impl& operator=(const lexer_impl&) = default;
   lexer_impl(lexer_impl&&) = default;
   lexer_impl& operator=(lexer_impl&&) = default;
   ~lexer_impl() = default;
 
-  auto do_lex();
+  auto do_lex() {
+    return do_lex(std::integral_constant<bool,
+        is_contiguous_iterator<buffer_iterator_type>::value>{});
+  }
  private:
   buffer_type* buffer;
-  translator_type* trans;
+  const translator_type* trans;
+  std::shared_ptr<const keyword_type> keywords;
+  // These run the translator's pattern rules and its keyword rules.
+  engine_type engine;
+  keyword_engine_type keyword_engine;
 
-  buffer_iterator<buffer_type> regex_match(regex_type& regex); 
+  using buffer_iterator_type = decltype(std::declval<buffer_type&>().begin());
+  auto do_lex(std::false_type);
+  auto do_lex(std::true_type);
 };
 
+// All the rules are matched at once in a single pass over the buffer: the
+// pattern rules by the engine and the keyword rules by the trie, side by
+// side. The longest match wins, and among matches of the same length the
+// earliest rule in the translator wins. Empty matches are never accepted.
 template <typename L>
-buffer_iterator<typename L::buffer_type> 
-lexer_impl<L>::regex_match(regex_type& regex) {
-  assert(regex.state() != match_state::MISMATCH);
-
+auto lexer_impl<L>::do_lex(std::false_type) {
+  // The match will be the range [begin, accepted).
   auto accepted = buffer->begin();
-  bool loop_done {false};
-  for (auto seek = buffer->begin(); !loop_done && seek != buffer->end();) {
-    regex.update(*seek);
+  auto rule = thread_flags::no_rule();
+
+  engine.initialize();
+  keyword_engine.initialize();
+  bool pattern_live {engine.state() != match_state::MISMATCH};
+  bool keyword_live {keyword_engine.state() != match_state::MISMATCH};
+  for (auto seek = buffer->begin(); 
+      (pattern_live || keyword_live) && seek != buffer->end();) {
+    auto ch = *seek;
     ++seek;
-    switch (regex.state()) {
-    case match_state::MATCH:
-      accepted = seek;
-      break;
-    case match_state::FINAL_MATCH:
+    auto matched = thread_flags::no_rule();
+    if (pattern_live) {
+      detail::advance_engine(engine, ch, pattern_live, matched);
+    }
+    if (keyword_live) {
+      detail::advance_engine(keyword_engine, ch, keyword_live, matched);
+    }
+    if (matched != thread_flags::no_rule()) {
       accepted = seek;
-      loop_done = true;
-      break;
-    case match_state::MISMATCH:
-      loop_done = true;
-      break;
-    case match_state::UNDECIDED:
-      break;
+      rule = matched;
     }
   }
-  // The regex needs to be reinitialized to be used again later.
-  regex.initialize();
-  return accepted;
+
+  if (rule == thread_flags::no_rule()) {
+    return std::make_pair(buffer->begin(), trans->end());
+  }
+  return std::make_pair(accepted, trans->begin() + rule);
 }
 
+// A contiguous buffer is cheap to read twice, so each engine matches on its
+// own, and the pattern engine takes its pointer loop.
 template <typename L>
-//typename lexer_impl<L>::lex_result lexer_impl<L>::do_lex() {
-auto lexer_impl<L>::do_lex() {
-  // The regex match will be the range [begin, accepted).
-  auto it = trans->begin();
-  while (it != trans->end()) {
-    auto regex = it->first;
-    auto accepted = regex_match(regex);
-    if (accepted != buffer->begin()) {
-      return std::make_pair(accepted, it);
-    }
-    ++it;
+auto lexer_impl<L>::do_lex(std::true_type) {
+  auto begin = buffer->begin();
+  auto end = buffer->end();
+  auto pattern_rule = thread_flags::no_rule();
+  auto keyword_rule = thread_flags::no_rule();
+  auto pattern_end = engine.match(begin, end, pattern_rule);
+  auto keyword_end = keyword_engine.match(begin, end, keyword_rule);
+
+  auto accepted = pattern_end;
+  auto rule = pattern_rule;
+  if (keyword_rule != thread_flags::no_rule() && 
+      (pattern_rule == thread_flags::no_rule() || 
+       keyword_end > pattern_end ||
+       (keyword_end == pattern_end && keyword_rule < pattern_rule))) {
+    accepted = keyword_end;
+    rule = keyword_rule;
+  }
+
+  if (rule == thread_flags::no_rule()) {
+    return std::make_pair(begin, trans->end());
   }
-  return std::make_pair(buffer->begin(), trans->end());
+  return std::make_pair(accepted, trans->begin() + rule);
 }
 
 }//namespace lex
@@ -0,0 +1,322 @@
+/*
+ * A push_lexer is fed its input in chunks, as they arrive, instead of
+ * pulling it from an iterator. feed() lexes a chunk and runs the action of
+ * every token it completes before returning, so it never waits for input.
+ * One thread can therefore serve many streams, with one push_lexer each.
+ *
+ * A token is complete as soon as no rule can match anything longer, so
+ * it may be emitted before the next chunk arrives. The engines keep their
+ * state between calls, so the input is never rescanned, except for the
+ * few characters read past the end of the longest match. Only the token
+ * still undecided at the end of a chunk is copied out of it; every other
+ * token is a view straight into the chunk. finish() marks the end of the
+ * input and lexes whatever is left.
+ *
+ * Once input matches no rule the lexer fails, and it lexes no further
+ * input. The unmatched characters, and any fed after them, are left in
+ * pending(), so they do not depend on how the input was split.
+ *
+ * Between calls the state of a push_lexer can be saved as a snapshot and
+ * restored later, in another process, into a push_lexer with the same
+ * rules. The snapshot layout is, in native byte order:
+ *   header        magic, format version, flags, rule count, character
+ *                 size, key, position, carry length
+ *   carry         the characters of the undecided token
+ * The engine states are not saved: the engines have only seen the carry
+ * since the token started, so restoring feeds it to them again. The key
+ * is chosen by the caller, usually as rule_set_hash() of the rules, and a
+ * snapshot is only restored with the same key.
+ */
+
+#ifndef _push_lexer_h_
+#define _push_lexer_h_
+
+#include "automaton/lazy_dfa.h"
+#include "automaton/literal_trie.h"
+#include "lex/lexer_impl.h"
+#include "lex/token_view.h"
+#include "lex/translator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <regex>
+#include <string>
+#include <utility>
+
+namespace lex {
+
+struct push_lexer_snapshot_header {
+  static constexpr std::uint32_t current_version = 1;
+  static constexpr std::uint32_t failed_flag = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t flags;
+  std::uint32_t rule_count;
+  std::uint32_t char_size;
+  std::uint64_t key;
+  std::uint64_t position;
+  std::uint64_t carry_length;
+};
+
+inline const char* push_lexer_snapshot_magic() {return "lexsnap\n";}
+
+template <typename CharT, typename Traits = std::regex_traits<CharT>>
+class push_lexer {
+ public:
+  using char_type = CharT;
+  using string_type = typename Traits::string_type;
+  // A token is only valid until its action returns. It may point into
+  // the chunk being fed or into the lexer's own carry over buffer.
+  using token_type = token_view<const char_type*>;
+  using function_type = std::function<void(token_type)>;
+  using translator_type = translator<push_lexer>;
+  using translator_item = std::pair<string_type, function_type>;
+
+  // Lexers constructed from the same pointer share one compiled rule set.
+  explicit push_lexer(std::shared_ptr<const translator_type> translator);
+  explicit push_lexer(const translator_type& translator)
+    : push_lexer(std::make_shared<const translator_type>(translator)) {}
+
+  // These return the number of tokens emitted.
+  std::size_t feed(const char_type* data, std::size_t n);
+  std::size_t feed(const string_type& s) {return feed(s.data(), s.size());}
+  // No input may be fed after this.
+  std::size_t finish();
+
+  bool failed() const {return failed_;}
+  // The number of characters lexed so far.
+  std::uint64_t position() const {return consumed;}
+  // The characters held over for the next chunk: the start of a token not
+  // yet decided or, after a failure, the input that matched no rule.
+  const string_type& pending() const {return carry;}
+
+  // This saves the state of the lexer as a byte string.
+  std::string snapshot(std::uint64_t key = 0) const;
+  // This fails if the snapshot is malformed, was saved with a different
+  // key or by a lexer with a different number of rules or character size.
+  // On failure the lexer is unchanged.
+  bool restore(const std::string& snapshot, std::uint64_t key = 0);
+ private:
+  using engine_type = lazy_dfa<char_type, Traits>;
+  using keyword_type = typename translator_type::keyword_type;
+  using keyword_engine_type = literal_trie_engine<char_type>;
+
+  std::shared_ptr<const translator_type> trans;
+  std::shared_ptr<const keyword_type> keywords;
+  engine_type engine;
+  keyword_engine_type keyword_engine;
+
+  // The engines have seen scanned characters of the current token. The
+  // longest match so far is its first accepted characters, for rule.
+  std::size_t scanned {0};
+  std::size_t accepted {0};
+  std::size_t rule {thread_flags::no_rule()};
+  bool pattern_live {false};
+  bool keyword_live {false};
+  bool failed_ {false};
+  std::uint64_t consumed {0};
+  // When the current token began in an earlier chunk, all of it that has
+  // been read is here.
+  string_type carry;
+
+  void start_token();
+  bool live() const {return pattern_live || keyword_live;}
+  void step(char_type ch);
+  // This emits the longest match of the current token, which starts at
+  // begin, or fails if there is none. It returns false on failure.
+  bool emit(const char_type* begin);
+  std::size_t drain_carry(const char_type* data, const char_type*& p,
+      const char_type* end, bool at_end);
+};
+
+template <typename CharT, typename Traits>
+push_lexer<CharT,Traits>::push_lexer(
+    std::shared_ptr<const translator_type> translator)
+  : trans {std::move(translator)},
+    keywords {trans->get_keywords()},
+    engine {trans->get_patterns()},
+    keyword_engine {*keywords} {
+  start_token();
+}
+
+template <typename CharT, typename Traits>
+void push_lexer<CharT,Traits>::start_token() {
+  engine.initialize();
+  keyword_engine.initialize();
+  pattern_live = engine.state() != match_state::MISMATCH;
+  keyword_live = keyword_engine.state() != match_state::MISMATCH;
+  scanned = 0;
+  accepted = 0;
+  rule = thread_flags::no_rule();
+}
+
+template <typename CharT, typename Traits>
+void push_lexer<CharT,Traits>::step(char_type ch) {
+  auto matched = thread_flags::no_rule();
+  if (pattern_live) {
+    detail::advance_engine(engine, ch, pattern_live, matched);
+  }
+  if (keyword_live) {
+    detail::advance_engine(keyword_engine, ch, keyword_live, matched);
+  }
+  ++scanned;
+  if (matched != thread_flags::no_rule()) {
+    accepted = scanned;
+    rule = matched;
+  }
+}
+
+template <typename CharT, typename Traits>
+bool push_lexer<CharT,Traits>::emit(const char_type* begin) {
+  if (rule == thread_flags::no_rule()) {
+    failed_ = true;
+    return false;
+  }
+  (trans->begin() + rule)->second(token_type(begin, begin + accepted));
+  consumed += accepted;
+  return true;
+}
+
+// The token in the carry is completed from the chunk, one character at a
+// time, and so are any tokens that start in the characters read past it.
+// This stops once a token starts in the chunk itself, which may then be
+// lexed in place. The chunk starts at data.
+template <typename CharT, typename Traits>
+std::size_t push_lexer<CharT,Traits>::drain_carry(const char_type* data,
+    const char_type*& p, const char_type* end, bool at_end) {
+  std::size_t emitted {0};
+  while (!carry.empty() && !failed_) {
+    if (live() && scanned < carry.size()) {
+      step(carry[scanned]);
+      continue;
+    }
+    if (live() && p != end) {
+      carry.push_back(*p++);
+      step(carry.back());
+      continue;
+    }
+    if (live() && !at_end) {
+      break;
+    }
+    if (!emit(carry.data())) {
+      // The rest of the chunk is kept too, as feed() keeps it.
+      carry.append(p, end);
+      p = end;
+      break;
+    }
+    ++emitted;
+    // When the characters read past the token all came from the chunk,
+    // they are left there to be lexed in place.
+    auto rest = carry.size() - accepted;
+    if (rest <= static_cast<std::size_t>(p - data)) {
+      p -= rest;
+      carry.clear();
+    } else {
+      carry.erase(0, accepted);
+    }
+    start_token();
+  }
+  return emitted;
+}
+
+template <typename CharT, typename Traits>
+std::size_t push_lexer<CharT,Traits>::feed(const char_type* data,
+    std::size_t n) {
+  if (failed_) {
+    carry.append(data, data + n);
+    return 0;
+  }
+  auto p = data;
+  auto end = data + n;
+  auto emitted = drain_carry(data, p, end, false);
+  if (failed_ || !carry.empty()) {
+    return emitted;
+  }
+
+  // The current token starts at begin, and the engines have seen the
+  // characters up to p.
+  auto begin = p;
+  while (p != end) {
+    step(*p++);
+    if (live()) {
+      continue;
+    }
+    if (!emit(begin)) {
+      carry.assign(begin, end);
+      return emitted;
+    }
+    ++emitted;
+    begin += accepted;
+    p = begin;
+    start_token();
+  }
+  carry.assign(begin, end);
+  return emitted;
+}
+
+template <typename CharT, typename Traits>
+std::size_t push_lexer<CharT,Traits>::finish() {
+  const char_type* none {nullptr};
+  return failed_? 0 : drain_carry(none, none, none, true);
+}
+
+template <typename CharT, typename Traits>
+std::string push_lexer<CharT,Traits>::snapshot(std::uint64_t key) const {
+  push_lexer_snapshot_header header;
+  std::memcpy(header.magic, push_lexer_snapshot_magic(), 
+      sizeof(header.magic));
+  header.version = push_lexer_snapshot_header::current_version;
+  header.flags = failed_? push_lexer_snapshot_header::failed_flag : 0;
+  header.rule_count = static_cast<std::uint32_t>(trans->size());
+  header.char_size = sizeof(char_type);
+  header.key = key;
+  header.position = consumed;
+  header.carry_length = carry.size();
+
+  std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.append(reinterpret_cast<const char*>(carry.data()),
+      carry.size() * sizeof(char_type));
+  return out;
+}
+
+template <typename CharT, typename Traits>
+bool push_lexer<CharT,Traits>::restore(const std::string& snapshot,
+    std::uint64_t key) {
+  push_lexer_snapshot_header header;
+  if (snapshot.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, snapshot.data(), sizeof(header));
+  if (std::memcmp(header.magic, push_lexer_snapshot_magic(), 
+        sizeof(header.magic)) ||
+      header.version != push_lexer_snapshot_header::current_version ||
+      header.key != key || header.rule_count != trans->size() ||
+      header.char_size != sizeof(char_type) ||
+      (header.flags & ~push_lexer_snapshot_header::failed_flag) != 0 ||
+      header.carry_length != 
+        (snapshot.size() - sizeof(header)) / sizeof(char_type) ||
+      (snapshot.size() - sizeof(header)) % sizeof(char_type) != 0) {
+    return false;
+  }
+
+  string_type restored(header.carry_length, char_type());
+  std::memcpy(&restored[0], snapshot.data() + sizeof(header),
+      header.carry_length * sizeof(char_type));
+  carry.swap(restored);
+  consumed = header.position;
+  failed_ = header.flags & push_lexer_snapshot_header::failed_flag;
+  start_token();
+  if (!failed_) {
+    for (auto ch : carry) {
+      step(ch);
+    }
+  }
+  return true;
+}
+
+}//namespace lex
+#endif// _push_lexer_h_
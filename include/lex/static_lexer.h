@@ -0,0 +1,116 @@
+/*
+ * A static_lexer is a lexer whose rules are fixed when it is compiled.
+ * Its dfa is built by the compiler (see automaton/static_dfa.h), so there
+ * is nothing to construct at run time, and its actions are called directly
+ * rather than through std::function.
+ *
+ * Each rule is a type providing
+ *   static constexpr const char* pattern();
+ *   static void action(ForwardIt begin, ForwardIt end);
+ * where the action may be a template over the iterator type. For example
+ *   struct number {
+ *     static constexpr const char* pattern() {return "[[:digit:]]+";}
+ *     template <typename It> static void action(It begin, It end);
+ *   };
+ *   using my_lexer = static_lexer<keyword, number, identifier>;
+ *
+ * Patterns are POSIX extended regular expressions, the syntax_option_type
+ * returned by static_syntax(), less the constructs static_dfa.h rejects.
+ *
+ * As in a lexer, the longest match wins, and among matches of the same
+ * length the earliest rule wins. Empty matches are never accepted.
+ */
+
+#ifndef _static_lexer_h_
+#define _static_lexer_h_
+
+#include "automaton/static_dfa.h"
+
+#include <cstddef>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+namespace lex {
+
+template <typename... Rules>
+class static_lexer {
+ public:
+  static constexpr std::size_t rule_count() {return sizeof...(Rules);}
+  static constexpr regex_constants::syntax_option_type static_syntax() {
+    return detail::static_syntax();
+  }
+  static constexpr std::size_t no_rule() {
+    return std::numeric_limits<std::size_t>::max();
+  }
+
+  // This returns the end of the longest nonempty match at the start of
+  // the range and sets rule to the rule matched. If nothing matches, begin
+  // is returned and rule is set to no_rule().
+  template <typename ForwardIt>
+  static constexpr ForwardIt match(ForwardIt begin, ForwardIt end,
+      std::size_t& rule);
+
+  // This matches one token and calls the action of its rule on it. It
+  // returns the end of the token, or begin if nothing matched, in which
+  // case no action is called.
+  template <typename ForwardIt>
+  static ForwardIt lex(ForwardIt begin, ForwardIt end);
+ private:
+  template <std::size_t I>
+  using rule_at = std::tuple_element_t<I, std::tuple<Rules...>>;
+
+  template <typename ForwardIt>
+  static void dispatch(std::size_t, ForwardIt, ForwardIt,
+      std::index_sequence<>) {}
+  template <typename ForwardIt, std::size_t I, std::size_t... Is>
+  static void dispatch(std::size_t rule, ForwardIt begin, ForwardIt end,
+      std::index_sequence<I, Is...>);
+};
+
+template <typename... Rules>
+template <typename ForwardIt>
+constexpr ForwardIt static_lexer<Rules...>::match(ForwardIt begin,
+    ForwardIt end, std::size_t& rule) {
+  const auto& table = static_dfa_v<Rules...>;
+  auto accepted = begin;
+  rule = no_rule();
+  auto state = table.start;
+  for (auto seek = begin; table.live[state] && seek != end;) {
+    auto byte = static_cast<unsigned char>(*seek);
+    state = table.next[state][table.classes[byte]];
+    ++seek;
+    if (table.rules[state] != std::numeric_limits<std::uint32_t>::max()) {
+      accepted = seek;
+      rule = table.rules[state];
+    }
+  }
+  return accepted;
+}
+
+template <typename... Rules>
+template <typename ForwardIt>
+ForwardIt static_lexer<Rules...>::lex(ForwardIt begin, ForwardIt end) {
+  std::size_t rule {no_rule()};
+  auto token_end = match(begin, end, rule);
+  if (rule != no_rule()) {
+    dispatch(rule, begin, token_end,
+        std::make_index_sequence<sizeof...(Rules)>{});
+  }
+  return token_end;
+}
+
+// Each action is called directly, so it can be inlined.
+template <typename... Rules>
+template <typename ForwardIt, std::size_t I, std::size_t... Is>
+void static_lexer<Rules...>::dispatch(std::size_t rule, ForwardIt begin,
+    ForwardIt end, std::index_sequence<I, Is...>) {
+  if (rule == I) {
+    rule_at<I>::action(begin, end);
+    return;
+  }
+  dispatch(rule, begin, end, std::index_sequence<Is...>{});
+}
+
+}//namespace lex
+#endif// _static_lexer_h_
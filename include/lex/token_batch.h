@@ -0,0 +1,58 @@
+/*
+ * These are the output formats of the batch interface of a lexer, which
+ * lexes many tokens per call without running any actions.
+ *
+ * A token_record is one token as three 32 bit numbers: the position of its
+ * rule in the translator, its offset and its length. token_columns holds
+ * the same numbers as three parallel arrays, which is the layout a
+ * vectorized consumer wants.
+ *
+ * Offsets are counted from the lexer's position at the start of the batch,
+ * so they fit in 32 bits whatever the size of the whole input. For
+ * token_columns that position is kept in base.
+ */
+
+#ifndef _token_batch_h_
+#define _token_batch_h_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lex {
+
+struct token_record {
+  std::uint32_t rule;
+  std::uint32_t offset;
+  std::uint32_t length;
+};
+
+struct token_columns {
+  // The position in the input of offset 0.
+  std::uint64_t base {0};
+  std::vector<std::uint32_t> rule;
+  std::vector<std::uint32_t> offset;
+  std::vector<std::uint32_t> length;
+
+  std::size_t size() const {return rule.size();}
+  bool empty() const {return rule.empty();}
+
+  void clear() {
+    rule.clear();
+    offset.clear();
+    length.clear();
+  }
+  void reserve(std::size_t n) {
+    rule.reserve(n);
+    offset.reserve(n);
+    length.reserve(n);
+  }
+  void push_back(std::uint32_t r, std::uint32_t o, std::uint32_t l) {
+    rule.push_back(r);
+    offset.push_back(o);
+    length.push_back(l);
+  }
+};
+
+}//namespace lex
+#endif// _token_batch_h_
@@ -0,0 +1,117 @@
+/*
+ * A token_view refers to the characters of a token where they lie in the
+ * input buffer. Actions receive a token_view instead of a string, so
+ * nothing is allocated or copied for a token unless the action asks for
+ * it. A view is only valid until the buffer is flushed, which happens as
+ * soon as the action returns.
+ *
+ * A token_view converts implicitly to a basic_string, so an action taking
+ * a const string_type& still works and pays for the copy only for its own
+ * tokens. When the buffer is contiguous, data() points to the first
+ * character.
+ */
+
+#ifndef _token_view_h_
+#define _token_view_h_
+
+#include "data_structures/contiguous_iterator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+namespace lex {
+
+template <typename Iterator>
+class token_view {
+ public:
+  using iterator = Iterator;
+  using const_iterator = Iterator;
+  using value_type = typename std::iterator_traits<Iterator>::value_type;
+  using string_type = std::basic_string<value_type>;
+  using size_type = std::size_t;
+
+  token_view() = default;
+  token_view(Iterator b, Iterator e)
+    : first {b},
+      last {e} {}
+
+  iterator begin() const {return first;}
+  iterator end() const {return last;}
+  bool empty() const {return first == last;}
+  // This takes linear time unless the iterators are random access or
+  // provide their own distance().
+  size_type size() const {
+    using std::distance;
+    return distance(first, last);
+  }
+
+  template <typename It = Iterator,
+            typename = std::enable_if_t<is_contiguous_iterator<It>::value>>
+  const value_type* data() const {
+    return empty()? nullptr : to_pointer(first);
+  }
+
+  // This copies the token.
+  string_type str() const {return string_type(first, last);}
+  operator string_type() const {return str();}
+ private:
+  Iterator first {};
+  Iterator last {};
+};
+
+template <typename Iterator>
+bool operator==(const token_view<Iterator>& token,
+    const typename token_view<Iterator>::string_type& s) {
+  return token.size() == s.size() &&
+    std::equal(token.begin(), token.end(), s.begin());
+}
+
+template <typename Iterator>
+bool operator==(const typename token_view<Iterator>::string_type& s,
+    const token_view<Iterator>& token) {
+  return token == s;
+}
+
+template <typename Iterator>
+bool operator!=(const token_view<Iterator>& token,
+    const typename token_view<Iterator>::string_type& s) {
+  return !(token == s);
+}
+
+template <typename Iterator>
+bool operator!=(const typename token_view<Iterator>::string_type& s,
+    const token_view<Iterator>& token) {
+  return !(token == s);
+}
+
+template <typename Iterator>
+bool operator==(const token_view<Iterator>& token,
+    const typename token_view<Iterator>::value_type* s) {
+  auto it = token.begin();
+  for (; it != token.end() && *s; ++it, ++s) {
+    if (*it != *s) return false;
+  }
+  return it == token.end() && !*s;
+}
+
+template <typename Iterator>
+bool operator!=(const token_view<Iterator>& token,
+    const typename token_view<Iterator>::value_type* s) {
+  return !(token == s);
+}
+
+template <typename Iterator>
+std::basic_ostream<typename token_view<Iterator>::value_type>&
+operator<<(std::basic_ostream<typename token_view<Iterator>::value_type>& os,
+    const token_view<Iterator>& token) {
+  std::copy(token.begin(), token.end(),
+      std::ostreambuf_iterator<typename token_view<Iterator>::value_type>(os));
+  return os;
+}
+
+}//namespace lex
+#endif// _token_view_h_
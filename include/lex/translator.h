@@ -1,11 +1,16 @@
 #ifndef _translator_h_
 #define _translator_h_
 
-#include "regex/regex_factory.h"
-#include "matcher/matcher.h"
+#include "automaton/literal_trie.h"
+#include "data_structures/arena.h"
+#include "data_structures/optional.h"
+#include "regex/regex.h"
 
+#include <cstddef>
 #include <functional>
 #include <initializer_list>
+#include <locale>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -13,17 +18,26 @@
 namespace lex {
 
 // The type L must provide a function_type and a char_type.
-template <typename Regex, typename F>
+// A translator is never modified after construction. Its rules and their
+// programs may therefore be shared by any number of lexers, on any
+// number of threads, as long as the functions in the table are themselves
+// safe to call concurrently.
+template <typename L>
 class translator {
  public:
-  using char_type        = typename Regex::char_type;
-  using regex_type       = matcher<char_type>;
+  using char_type        = typename L::char_type;
+  using regex_type       = regex<char_type>;
   using string_type      = std::basic_string<char_type>;
-  using function_type    = F;
+  using function_type    = typename L::function_type;
   using proto_value_type = std::pair<string_type, function_type>;
   using value_type       = std::pair<regex_type, function_type>;
   using table_type       = std::vector<value_type>; 
-  using iterator         = typename table_type::iterator;
+  using iterator         = typename table_type::const_iterator;
+  using const_iterator   = typename table_type::const_iterator;
+  using program_type     = typename regex_type::program_type;
+  using program_pointer  = std::shared_ptr<const program_type>;
+  using keyword_type     = literal_trie<char_type>;
+  using keyword_pointer  = std::shared_ptr<const keyword_type>;
 
   // Iterator::value_type must be proto_value_type.
   // The following constructors make a translator object from lists
@@ -31,30 +45,125 @@ class translator {
   template <typename Iterator, 
             typename = enable_iterator_t<Iterator,proto_value_type>>
   translator(Iterator begin, Iterator end);
+  // This compiles the rules with all their scratch memory taken from the
+  // given arena, which may be released once the translator is built.
+  template <typename Iterator, 
+            typename = enable_iterator_t<Iterator,proto_value_type>>
+  translator(Iterator begin, Iterator end, arena& region);
   translator(
       std::initializer_list<proto_value_type> l)
     : translator(l.begin(), l.end()) {}
   translator(const std::vector<proto_value_type>& v)
     : translator(v.begin(), v.end()) {}
   // The following constructors make a translator object from lists
-  // using pre-constructed matcher<char_type> objects.
+  // using pre-constructed regex<char_type> objects.
   translator(std::initializer_list<value_type> l)
-    : table(l) {}
+    : table(l) {combine();}
   translator(const std::vector<value_type>& v)
-    : table(v) {}
+    : table(v) {combine();}
+
+  const_iterator begin() const {return table.begin();} 
+  const_iterator end() const {return table.end();}
+  std::size_t size() const {return table.size();}
 
-  iterator begin() {return table.begin();} 
-  iterator end() {return table.end();}
+  // This is the single program for all the rules. Its MATCH instructions
+  // carry the position of their rule in the table. No lexer needs it, so
+  // it is not kept: each call joins the rules again.
+  program_pointer get_program() const;
+
+  // The rules that only match literal strings are also kept in a trie.
+  // get_patterns() is the program of all the other rules. A lexer runs
+  // both, so its cost per character does not grow with the number of
+  // keywords. Neither pointer is ever null.
+  keyword_pointer get_keywords() const {return keywords;}
+  program_pointer get_patterns() const {return patterns;}
  private:
   table_type table;
+  keyword_pointer keywords;
+  program_pointer patterns;
+
+  void combine();
+  program_pointer join(const std::vector<std::size_t>& rules) const;
 };
 
-template <typename Regex, typename F>
+template <typename L>
+template <typename Iterator, typename>
+translator<L>::translator(Iterator begin, Iterator end) {
+  using std::make_pair;
+  for (auto it = begin; it != end; ++it) {
+    table.push_back(make_pair(regex_type(it->first), it->second));
+  }
+  combine();
+}
+
+template <typename L>
 template <typename Iterator, typename>
-translator<Regex,F>::translator(Iterator begin, Iterator end) {
+translator<L>::translator(Iterator begin, Iterator end, arena& region) {
+  arena_scope scope(region);
   using std::make_pair;
   for (auto it = begin; it != end; ++it) {
-    table.push_back(make_pair(create_regex(it->first), it->second));
+    table.push_back(make_pair(regex_type(it->first), it->second));
+  }
+  combine();
+}
+
+// The rules are joined as program_builder::append_rule() describes.
+template <typename L>
+typename translator<L>::program_pointer
+translator<L>::join(const std::vector<std::size_t>& rules) const {
+  program_builder<char_type, typename regex_type::traits_type> builder;
+  for (std::size_t i = 0; i < rules.size(); ++i) {
+    builder.append_rule(table[rules[i]].first.get_program(), rules[i],
+        i + 1 == rules.size());
+  }
+  return std::make_shared<const program_type>(builder.release());
+}
+
+template <typename L>
+typename translator<L>::program_pointer translator<L>::get_program() const {
+  std::vector<std::size_t> all;
+  for (std::size_t rule = 0; rule < table.size(); ++rule) {
+    all.push_back(rule);
+  }
+  return join(all);
+}
+
+template <typename L>
+void translator<L>::combine() {
+  std::vector<std::size_t> pattern_rules;
+  std::vector<std::pair<string_type, std::size_t>> words;
+  std::vector<std::pair<string_type, std::size_t>> folded_words;
+  // The keywords of icase rules are folded by the locale of the first of
+  // them. Those of rules in another locale are left as patterns.
+  optional<std::locale> folding;
+  for (std::size_t rule = 0; rule < table.size(); ++rule) {
+    const auto& reg = table[rule].first;
+    bool icase {(reg.flags() & regex_constants::icase) != 0};
+    if (icase && !folding) {
+      folding = reg.getloc();
+    }
+    optional<std::vector<string_type>> literals;
+    if (!icase) {
+      literals = literal_alternatives(reg.get_program());
+    } else if (*folding == reg.getloc()) {
+      literals = folded_alternatives(reg.get_program());
+    }
+    if (!literals) {
+      pattern_rules.push_back(rule);
+      continue;
+    }
+    for (auto& word : *literals) {
+      (icase? folded_words : words).emplace_back(std::move(word), rule);
+    }
+  }
+  patterns = join(pattern_rules);
+  if (folding) {
+    keywords = std::make_shared<const keyword_type>(words.begin(), 
+        words.end(), folded_words.begin(), folded_words.end(),
+        std::use_facet<std::ctype<char_type>>(*folding));
+  } else {
+    keywords = std::make_shared<const keyword_type>(words.begin(), 
+        words.end());
   }
 }
 
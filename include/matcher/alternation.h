@@ -9,7 +9,9 @@
 #include "matcher/matcher.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <list>
+#include <memory>
 #include <vector>
 #include <utility>
 
@@ -41,7 +43,8 @@ match_state alternation_state(MatcherIterator begin,
 }
 
 // This defines the transition function for the alternation of several
-// regexes.
+// regexes. The branches in their initial states never change, so they are
+// shared by every clone.
 template <typename Matcher>
 class alternation_impl 
   : public matcher_impl_cloner<
@@ -51,17 +54,23 @@ class alternation_impl
  public:
   using matcher_type = Matcher;
   using value_type = typename Matcher::value_type;
+  using builder_type = typename Matcher::builder_type;
+  using prototype_list = matcher_list<matcher_type>;
 
-  alternation_impl(const std::vector<matcher_type>& c)
-    : initial_state {c} {}
-  alternation_impl(std::vector<matcher_type>&& c)
-    : initial_state {std::move(c)} {}
+  alternation_impl(prototype_list&& c)
+    : initial_state {detail::share_matchers(std::move(c))} {}
+  template <typename Container>
+  alternation_impl(const Container& c)
+    : initial_state {detail::share_matchers<matcher_type>(c)} {}
 
   match_state update(value_type) override;
   match_state initialize() override;
+  void emit(builder_type& builder) const override;
+  bool same_state(const matcher_impl<value_type, 
+      typename Matcher::traits_type>& other) const override;
  private:
-  std::vector<matcher_type> initial_state;
-  std::list<matcher_type> matchers;
+  std::shared_ptr<const prototype_list> initial_state;
+  std::list<matcher_type, arena_allocator<matcher_type>> matchers;
 };
 
 template <typename Matcher>
@@ -121,14 +130,60 @@ match_state alternation_impl<Matcher>::initialize() {
 
   matchers.clear();
 
-  for_each(initial_state.begin(), initial_state.end(),
-      [this] (matcher_type& r) {
+  for_each(initial_state->begin(), initial_state->end(),
+      [this] (const matcher_type& r) {
         if (r.state() != match_state::MISMATCH) {
           this->matchers.push_back(r);
         }
       });
 
-  return alternation_state(initial_state.begin(), initial_state.end());
+  return alternation_state(initial_state->begin(), initial_state->end());
+}
+// The list does not record which branch each matcher came from. Only
+// while no branch has been dropped do the two lists line up branch by
+// branch, so only then are they compared.
+template <typename Matcher>
+bool alternation_impl<Matcher>::same_state(const matcher_impl<value_type,
+    typename Matcher::traits_type>& other) const {
+  auto& that = static_cast<const alternation_impl&>(other);
+  auto branches = std::count_if(initial_state->begin(), initial_state->end(),
+      [] (const matcher_type& r) {
+        return r.state() != match_state::MISMATCH;
+      });
+  if (matchers.size() != static_cast<std::size_t>(branches) || 
+      that.matchers.size() != matchers.size()) {
+    return false;
+  }
+  return std::equal(matchers.begin(), matchers.end(), that.matchers.begin(),
+      [] (const matcher_type& a, const matcher_type& b) {
+        return a.same_state(b);
+      });
+}
+
+// Each branch but the last is guarded by a SPLIT whose second target is the
+// next branch. Every branch then jumps past the whole alternation:
+//      SPLIT L1, L2
+//  L1: <branch 1>
+//      JUMP L3
+//  L2: <branch 2>
+//  L3:
+template <typename Matcher>
+void alternation_impl<Matcher>::emit(builder_type& builder) const {
+  using index_type = typename builder_type::index_type;
+  if (initial_state->empty()) return;
+
+  std::vector<index_type> jumps;
+  auto last = initial_state->end() - 1;
+  for (auto it = initial_state->begin(); it != last; ++it) {
+    auto split = builder.emit_split(builder.position() + 1, 0);
+    it->emit(builder);
+    jumps.push_back(builder.emit_jump(0));
+    builder.patch_y(split, builder.position());
+  }
+  last->emit(builder);
+  for (auto jump : jumps) {
+    builder.patch_x(jump, builder.position());
+  }
 }
 }//namespace detail
 
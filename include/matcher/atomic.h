@@ -1,9 +1,11 @@
 #ifndef _atomic_h_
 #define _atomic_h_
 
+#include "matcher/ctype_table.h"
 #include "matcher/matcher.h"
 
 #include <locale>
+#include <string>
 #include <vector>
 
 namespace lex {
@@ -17,6 +19,7 @@ struct singleton_matcher_impl
          > {
  public:
   using typename matcher_impl<CharT, Traits>::value_type;
+  using typename matcher_impl<CharT, Traits>::builder_type;
   using traits_type = Traits;
 
   singleton_matcher_impl(value_type t, const Traits& tr)
@@ -27,6 +30,13 @@ struct singleton_matcher_impl
   // character it receives (t), is a match.
   match_state update(value_type t) override;
   match_state initialize() override;
+  void emit(builder_type& builder) const override {
+    builder.emit_char(match);
+  }
+  // All the state is in the matcher's match_state.
+  bool same_state(const matcher_impl<CharT, Traits>&) const override {
+    return true;
+  }
  private:
   const traits_type& traits_;
   value_type match;
@@ -56,7 +66,8 @@ matcher<CharT, Traits> singleton_matcher(CharT ch, const Traits& traits) {
 // The matcher object corresponding to a predicate on a single char. 
 // E.g. [:alpha:]
 // In order for the initialize() method to be semantically correct, 
-// the predicate Pred must be stateless.
+// the predicate Pred must be stateless. If folded is not null, the
+// predicate accepts exactly the cases of folded, which is in lower case.
 namespace detail {
 template <typename CharT, typename Traits>
 class predicate_matcher_impl 
@@ -65,15 +76,24 @@ class predicate_matcher_impl
            > {
  public:
   using typename matcher_impl<CharT, Traits>::value_type;
+  using typename matcher_impl<CharT, Traits>::builder_type;
   using predicate_type = predicate_type_t<CharT>;
 
-  predicate_matcher_impl(predicate_type p) 
-    : pred {p} {}
+  predicate_matcher_impl(predicate_type p, value_type f) 
+    : pred {p},
+      folded {f} {}
 
   match_state update(CharT t) override;
   match_state initialize() override;
+  void emit(builder_type& builder) const override {
+    builder.emit_predicate(pred, folded);
+  }
+  bool same_state(const matcher_impl<CharT, Traits>&) const override {
+    return true;
+  }
  private:
   predicate_type pred;
+  value_type folded;
 };
 
 template <typename CharT, typename Traits>
@@ -91,9 +111,10 @@ match_state predicate_matcher_impl<CharT, Traits>::initialize() {
 }
 }//namespace detail
 template <typename CharT, typename Traits>
-matcher<CharT, Traits> predicate_matcher(predicate_type_t<CharT> p) {
+matcher<CharT, Traits> predicate_matcher(predicate_type_t<CharT> p,
+    CharT folded = CharT('\0')) {
   matcher_factory<detail::predicate_matcher_impl<CharT, Traits>> fac;
-  return fac.create(p);
+  return fac.create(p, folded);
 }
 
 // This creates a matcher that matches a '.'. The predicate
@@ -103,54 +124,44 @@ matcher<CharT, Traits> universal_singleton_matcher() {
   return predicate_matcher<CharT, Traits>([](auto){return true;});
 }
 
+// The class tests use the shared ctype_table of the class in the traits'
+// locale, so for most characters they are a single bit test. The upper
+// case escapes match the complements. Under icase \l and \u both match
+// any letter.
 template <typename CharT, typename Traits>
-matcher<CharT, Traits> character_class_matcher(CharT ch, const Traits& traits) {
-  auto loc = traits.getloc();
+matcher<CharT, Traits> character_class_matcher(CharT ch, const Traits& traits,
+    bool icase = false) {
+  std::string name;
   switch (ch) {
   case CharT('.'):
     return predicate_matcher<CharT, Traits>([](auto ch) {return true;});
-  case CharT('w'):
-    return predicate_matcher<CharT, Traits>([loc](auto ch) {
-          return std::isalnum(ch, loc) || ch == CharT('_');
-        });
-  case CharT('W'):
-    return predicate_matcher<CharT, Traits>([loc](auto ch) {
-          return !std::isalnum(ch, loc) && ch != CharT('_');
-        });
-  case CharT('d'):
-    return predicate_matcher<CharT, Traits>([loc](auto ch) {
-          return std::isdigit(ch, loc);
-        });
-  case CharT('D'):
-    return predicate_matcher<CharT, Traits>([loc](auto ch) {
-          return !std::isdigit(ch, loc);
-        });
-  case CharT('s'):
-    return predicate_matcher<CharT, Traits>([loc](auto ch) {
-          return std::isspace(ch, loc);
-        });
-  case CharT('S'):
-    return predicate_matcher<CharT, Traits>([loc](auto ch) {
-          return !std::isspace(ch, loc);
-        });
-  case CharT('l'):
-    return predicate_matcher<CharT, Traits>([loc](auto ch) {
-          return std::islower(ch, loc);
-        });
-  case CharT('L'):
-    return predicate_matcher<CharT, Traits>([loc](auto ch) {
-          return !std::islower(ch, loc);
-        });
-  case CharT('u'):
-    return predicate_matcher<CharT, Traits>([loc](auto ch) {
-          return std::isupper(ch, loc);
-        });
-  case CharT('U'):
-    return predicate_matcher<CharT, Traits>([loc](auto ch) {
-          return !std::isupper(ch, loc);
-        });
+  case CharT('w'): case CharT('W'):
+    name = "w";
+    break;
+  case CharT('d'): case CharT('D'):
+    name = "d";
+    break;
+  case CharT('s'): case CharT('S'):
+    name = "s";
+    break;
+  case CharT('l'): case CharT('L'):
+    name = "lower";
+    break;
+  case CharT('u'): case CharT('U'):
+    name = "upper";
+    break;
+  default:
+    return {};
+  }
+  auto table = ctype_table<CharT>::get(traits, name, icase);
+  if (!table) {
+    return {};
   }
-  return {};
+  const bool negated {ch == CharT('W') || ch == CharT('D') || 
+    ch == CharT('S') || ch == CharT('L') || ch == CharT('U')};
+  return predicate_matcher<CharT, Traits>([table, negated](auto ch) {
+        return table->is(ch) != negated;
+      });
 }
 
 
@@ -4,7 +4,7 @@
 #include "matcher/matcher.h"
 
 #include <cstddef>
-#include <list>
+#include <memory>
 #include <vector>
 #include <utility>
 
@@ -12,10 +12,10 @@ namespace lex {
 namespace detail {
 // We need to handle concatenation of a list of matchers.
 // We need to keep a list of all the individual matchers in their
-// initial states.
+// initial states. That list never changes, so it is shared by every clone.
 // The current state will be maintained by a list of matchers.
 // Each entry in the list represents a parallel progression through
-// the concatenation.
+// the concatenation. Progressions in the same state are merged.
 template <typename Matcher>
 class concatenate_impl 
   : public matcher_impl_cloner<
@@ -27,19 +27,32 @@ class concatenate_impl
   using value_type = typename matcher_type::value_type;
   using index_type = std::size_t;
   using current_progress = std::pair<matcher_type, index_type>;
+  using builder_type = typename matcher_type::builder_type;
+  using prototype_list = matcher_list<matcher_type>;
+  using progress_list = detail::progress_list<matcher_type>;
 
-  concatenate_impl(const std::vector<matcher_type>& container)
-    : initial_state(container) {}
-  concatenate_impl(std::vector<matcher_type>&& container)
-    : initial_state(std::move(container)) {}
+  concatenate_impl(prototype_list&& container)
+    : initial_state {detail::share_matchers(std::move(container))} {}
+  template <typename Container>
+  concatenate_impl(const Container& container)
+    : initial_state {detail::share_matchers<matcher_type>(container)} {}
 
   match_state update(value_type ch) override;
   match_state initialize() override;
+  void emit(builder_type& builder) const override;
+  bool same_state(const matcher_impl<value_type, 
+      typename matcher_type::traits_type>& other) const override {
+    return same_progress(current, 
+        static_cast<const concatenate_impl&>(other).current);
+  }
  private:
-  std::vector<matcher_type> initial_state;
-  std::list<current_progress> current;
+  std::shared_ptr<const prototype_list> initial_state;
+  progress_list current;
+  // The next list is built here and then swapped in, so neither list
+  // allocates once it has grown.
+  progress_list next;
 
-  void insert_next(typename std::list<current_progress>::const_iterator it);
+  void spawn(index_type matcher_index);
 };
 
 // To understand this implementation consider the concatenation of
@@ -71,43 +84,43 @@ concatenate_impl<Matcher>::update(value_type ch) {
   bool final_match {false};
   bool match {false};
 
-  for (auto it = current.begin(); it != current.end();) {
-    it->first.update(ch);
-    auto state = it->first.state();
+  for (auto& progress : current) {
+    progress.first.update(ch);
+    auto state = progress.first.state();
     // matcher_index points to the next matcher in the initial_state vector.
-    auto matcher_index = it->second;
+    auto matcher_index = progress.second;
     switch (state) {
     // If another matcher is available, we spawn a parallel progression.
     // If not, we have matched the whole concatenation.
     case match_state::MATCH:
-      if (matcher_index == initial_state.size()) {
+      if (matcher_index == initial_state->size()) {
         match = true;
       } else {
         undecided = true;
-        insert_next(it);
+        spawn(matcher_index);
       }
-      ++it;
+      add_progress(next, std::move(progress.first), matcher_index);
       break;
+    // This matcher will no longer match anything, so we detach it.
     case match_state::FINAL_MATCH:
-      if (matcher_index == initial_state.size()) {
+      if (matcher_index == initial_state->size()) {
         final_match = true;
       } else {
         undecided = true;
-        insert_next(it);
+        spawn(matcher_index);
       }
-      // This matcher will no longer match anything, so we detach.
-      it = current.erase(it);
       break;
     case match_state::UNDECIDED:
       undecided = true;
-      ++it;
+      add_progress(next, std::move(progress.first), matcher_index);
       break;
     // A MISMATCH state matcher is detached.
     case match_state::MISMATCH:
-      it = current.erase(it);
       break;
     }
   }
+  current.swap(next);
+  next.clear();
   if (match) {
     return match_state::MATCH;
   } else if (final_match && undecided) {
@@ -121,13 +134,11 @@ concatenate_impl<Matcher>::update(value_type ch) {
   }
 }
 
+// The new progression starts on the next operand, which is only copied if
+// no progression on it is still in its initial state.
 template <typename Matcher>
-void concatenate_impl<Matcher>::insert_next(
-    typename std::list<current_progress>::const_iterator it) {
-  using std::make_pair;
-  auto matcher_index = it->second;
-  current.insert(it, 
-      make_pair(initial_state[matcher_index], matcher_index + 1));
+void concatenate_impl<Matcher>::spawn(index_type matcher_index) {
+  add_progress(next, (*initial_state)[matcher_index], matcher_index + 1);
 }
 
 // Consider the concatenation of "A?" with "B?".
@@ -138,14 +149,14 @@ template <typename Matcher>
 match_state concatenate_impl<Matcher>::initialize() {
   current.clear();
 
-  if (initial_state.empty()) {
+  if (initial_state->empty()) {
     return match_state::MATCH;
   }
 
   auto r_state = match_state::UNDECIDED;
 
-  for (index_type index = 0; index < initial_state.size(); ++index) {
-    r_state = initial_state[index].state();
+  for (index_type index = 0; index < initial_state->size(); ++index) {
+    r_state = (*initial_state)[index].state();
 
     // If one of the operands starts out in the MISMATCH state, then the
     // whole concatenation will also be a MISMATCH with anything.
@@ -153,7 +164,7 @@ match_state concatenate_impl<Matcher>::initialize() {
       current.clear();
       return match_state::MISMATCH;
     } else if (r_state != match_state::FINAL_MATCH) {
-      current.push_back(std::make_pair(initial_state[index], index + 1));
+      current.push_back(std::make_pair((*initial_state)[index], index + 1));
     }
     if (r_state == match_state::UNDECIDED) break;
   }
@@ -163,6 +174,13 @@ match_state concatenate_impl<Matcher>::initialize() {
   }
   return r_state;
 }
+// The lowered operands are simply laid out one after another.
+template <typename Matcher>
+void concatenate_impl<Matcher>::emit(builder_type& builder) const {
+  for (const auto& m : *initial_state) {
+    m.emit(builder);
+  }
+}
 }//namespace detail
 
 // This function creates the concatenation object.
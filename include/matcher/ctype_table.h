@@ -0,0 +1,189 @@
+/*
+ * A ctype_table is a snapshot of one character class of a regex traits
+ * object, such as alpha or w. Traits::isctype() is asked about each of the
+ * first 256 character values once, when the table is built, so testing
+ * one of those characters for the class is a single bit test instead of a
+ * call through the traits. Wider characters are passed to the ctype facet
+ * of the traits' locale, or to a copy of the traits for a class the facet
+ * has no mask for.
+ *
+ * Tables are cached per traits type, locale, class name and icase, and
+ * shared by every matcher that asks for the same class. The cache only
+ * holds weak pointers, and entries whose table has expired are dropped,
+ * along with their locale, whenever a table is looked up. It therefore
+ * only grows with the number of classes in use.
+ *
+ * A ctype_class is a character class by ctype mask, such as alpha, which
+ * may also include '_' as \w and [:w:] do.
+ */
+
+#ifndef _ctype_table_h_
+#define _ctype_table_h_
+
+#include "data_structures/byte_set.h"
+#include "data_structures/optional.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <locale>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace lex {
+
+struct ctype_class {
+  std::ctype_base::mask mask;
+  bool word;
+};
+
+template <typename String>
+optional<ctype_class> lookup_ctype_class(const String& name, bool icase);
+
+template <typename CharT>
+class ctype_table {
+ public:
+  using char_type = CharT;
+  using pointer = std::shared_ptr<const ctype_table>;
+
+  // This returns the shared table of the named class, building it if
+  // needed, or null if the traits do not know the name. Under icase lower
+  // and upper name alpha, as Traits::lookup_classname() has it.
+  template <typename Traits, typename String>
+  static pointer get(const Traits& traits, const String& name, bool icase) {
+    return find(traits, typename Traits::string_type(name.begin(),
+          name.end()), icase);
+  }
+
+  bool is(char_type ch) const {
+    auto code = static_cast<std::make_unsigned_t<char_type>>(ch);
+    return code < table_size? bytes.contains(static_cast<unsigned char>(code))
+      : wide(ch);
+  }
+ private:
+  static constexpr std::size_t table_size = 256;
+
+  detail::byte_set bytes;
+  // This is only called for characters outside the table. The locale
+  // keeps its facet alive.
+  std::function<bool(char_type)> wide;
+  std::locale loc;
+
+  // There is one cache for each traits type.
+  template <typename Traits>
+  static pointer find(const Traits& traits,
+      const typename Traits::string_type& key, bool icase);
+
+  template <typename Traits>
+  ctype_table(const Traits& traits,
+      typename Traits::char_class_type cls,
+      const typename Traits::string_type& name, bool icase);
+};
+
+template <typename CharT>
+constexpr std::size_t ctype_table<CharT>::table_size;
+
+template <typename CharT>
+template <typename Traits>
+ctype_table<CharT>::ctype_table(const Traits& traits,
+    typename Traits::char_class_type cls,
+    const typename Traits::string_type& name, bool icase) {
+  for (std::size_t code = 0; code != table_size; ++code) {
+    if (traits.isctype(static_cast<char_type>(code), cls)) {
+      bytes.insert(static_cast<unsigned char>(code));
+    }
+  }
+  if (sizeof(char_type) == 1) {
+    return;
+  }
+  auto c = lookup_ctype_class(name, icase);
+  if (!c) {
+    wide = [traits, cls] (char_type ch) {return traits.isctype(ch, cls);};
+    return;
+  }
+  loc = traits.getloc();
+  const auto* facet = &std::use_facet<std::ctype<char_type>>(loc);
+  wide = [facet, c = *c] (char_type ch) {
+    return facet->is(c.mask, ch) || (c.word && ch == char_type('_'));
+  };
+}
+
+template <typename CharT>
+template <typename Traits>
+typename ctype_table<CharT>::pointer
+ctype_table<CharT>::find(const Traits& traits,
+    const typename Traits::string_type& key, bool icase) {
+  using string_type = typename Traits::string_type;
+  struct entry {
+    std::locale loc;
+    string_type name;
+    bool icase;
+    std::weak_ptr<const ctype_table> table;
+  };
+  static std::mutex lock;
+  static std::vector<entry> tables;
+
+  auto loc = traits.getloc();
+  std::lock_guard<std::mutex> guard(lock);
+  tables.erase(std::remove_if(tables.begin(), tables.end(),
+        [](const entry& e) {return e.table.expired();}), tables.end());
+  for (const auto& e : tables) {
+    if (e.icase == icase && e.name == key && e.loc == loc) {
+      if (auto table = e.table.lock()) {
+        return table;
+      }
+    }
+  }
+
+  auto cls = traits.lookup_classname(key.begin(), key.end(), icase);
+  if (cls == typename Traits::char_class_type()) {
+    return nullptr;
+  }
+  pointer table(new ctype_table(traits, cls, key, icase));
+  tables.push_back(entry {loc, key, icase, table});
+  return table;
+}
+
+// This finds the class with a name accepted by std::regex_traits, or
+// nothing. Under icase, lower and upper both name alpha.
+template <typename String>
+optional<ctype_class> lookup_ctype_class(const String& name, bool icase) {
+  using base = std::ctype_base;
+  struct entry {
+    const char* name;
+    base::mask mask;
+    bool word;
+  };
+  static const entry classes[] {
+    {"alnum", base::alnum, false}, {"alpha", base::alpha, false},
+    {"blank", base::blank, false}, {"cntrl", base::cntrl, false},
+    {"digit", base::digit, false}, {"d", base::digit, false},
+    {"graph", base::graph, false}, {"lower", base::lower, false},
+    {"print", base::print, false}, {"punct", base::punct, false},
+    {"space", base::space, false}, {"s", base::space, false},
+    {"upper", base::upper, false}, {"xdigit", base::xdigit, false},
+    {"w", base::alnum, true}
+  };
+
+  std::string narrow;
+  for (auto ch : name) {
+    if (ch < 0 || ch > 127) return {};
+    narrow.push_back(static_cast<char>(ch));
+  }
+  for (const auto& c : classes) {
+    if (narrow == c.name) {
+      auto mask = c.mask;
+      if (icase && (mask == base::lower || mask == base::upper)) {
+        mask = base::alpha;
+      }
+      return ctype_class {mask, c.word};
+    }
+  }
+  return {};
+}
+
+}//namespace lex
+#endif// _ctype_table_h_
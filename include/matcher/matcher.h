@@ -1,11 +1,14 @@
 #ifndef _matcher_h_
 #define _matcher_h_
 
+#include "data_structures/arena.h"
 #include "matcher/matcher_impl.h"
 #include "regex_types.h"
 
+#include <cstddef>
 #include <memory>
 #include <utility>
+#include <vector>
 
 namespace lex {
 
@@ -34,6 +37,7 @@ class matcher {
   using traits_type = Traits;
   using impl_pointer = 
     typename matcher_impl<CharT, Traits>::pointer;
+  using builder_type = program_builder<CharT, Traits>;
 
   // The default matcher matches an empty string.
   matcher() 
@@ -46,9 +50,9 @@ class matcher {
       state_ {impl_->initialize()} {}
 
   matcher(const matcher& r);
-  matcher(matcher&& r);
+  matcher(matcher&& r) noexcept;
   matcher& operator=(const matcher& r);
-  matcher& operator=(matcher&& r);
+  matcher& operator=(matcher&& r) noexcept;
 
   match_state state() const {return state_;}
 
@@ -60,6 +64,14 @@ class matcher {
   // the state is converted to the original state of the original matcher 
   // which was constructed from a impl_pointer object.
   void initialize() {state_ = impl_->initialize();}
+
+  // This appends the program corresponding to the matcher's initial state.
+  void emit(builder_type& builder) const {impl_->emit(builder);}
+
+  // Both matchers must be copies of the same original matcher.
+  bool same_state(const matcher& other) const {
+    return state_ == other.state_ && impl_->same_state(*other.impl_);
+  }
  private:
   impl_pointer impl_;
   match_state state_;
@@ -72,7 +84,7 @@ matcher<CharT, Traits>::matcher(const matcher& r)
     state_ {r.state_} {}
 // Move constructor.
 template <typename CharT, typename Traits>
-matcher<CharT, Traits>::matcher(matcher&& r)
+matcher<CharT, Traits>::matcher(matcher&& r) noexcept
   : impl_ {std::move(r.impl_)},
     state_ {r.state_} {}
 // Copy assignment.
@@ -84,7 +96,8 @@ matcher<CharT, Traits>& matcher<CharT, Traits>::operator=(const matcher& r) {
 }
 // Move assignment.
 template <typename CharT, typename Traits>
-matcher<CharT, Traits>& matcher<CharT, Traits>::operator=(matcher&& r) {
+matcher<CharT, Traits>& 
+matcher<CharT, Traits>::operator=(matcher&& r) noexcept {
   impl_ = std::move(r.impl_);
   state_ = r.state_;
   return *this;
@@ -117,13 +130,91 @@ struct matcher_factory {
 
   template <typename ...Args>
   matcher_type create(Args&& ...args) const {
-    using std::make_unique;
     using std::forward;
     return 
-      matcher_type(make_unique<MatcherImpl>(forward<Args>(args)...));
+      matcher_type(make_arena_unique<MatcherImpl>(forward<Args>(args)...));
   }
 };
 
+// Composite matchers keep their operands in a matcher_list. Like the
+// matchers themselves, the lists come from the current arena, if any.
+template <typename Matcher>
+using matcher_list = std::vector<Matcher, arena_allocator<Matcher>>;
+
+namespace detail {
+
+// Concatenation and replication follow several progressions through their
+// operands at once: a matcher paired with an index. They are kept in a
+// contiguous list, and a progression identical to one already in the list
+// is dropped, so the list never holds more progressions than there are
+// distinct states of the operands.
+template <typename Matcher>
+using progress_list = 
+  std::vector<std::pair<Matcher, std::size_t>, 
+    arena_allocator<std::pair<Matcher, std::size_t>>>;
+
+template <typename Matcher>
+bool has_progress(const progress_list<Matcher>& list, const Matcher& m,
+    std::size_t index) {
+  for (const auto& p : list) {
+    if (p.second == index && p.first.same_state(m)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// These add a progression unless the list has one in the same state.
+template <typename Matcher>
+void add_progress(progress_list<Matcher>& list, Matcher&& m,
+    std::size_t index) {
+  if (!has_progress(list, m, index)) {
+    list.emplace_back(std::move(m), index);
+  }
+}
+
+template <typename Matcher>
+void add_progress(progress_list<Matcher>& list, const Matcher& m,
+    std::size_t index) {
+  if (!has_progress(list, m, index)) {
+    list.emplace_back(m, index);
+  }
+}
+
+template <typename Matcher>
+bool same_progress(const progress_list<Matcher>& a, 
+    const progress_list<Matcher>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i != a.size(); ++i) {
+    if (a[i].second != b[i].second || !a[i].first.same_state(b[i].first)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// This makes the shared list of operands of a composite matcher from any
+// container of matchers.
+template <typename Matcher>
+std::shared_ptr<const matcher_list<Matcher>> 
+share_matchers(matcher_list<Matcher>&& container) {
+  using list_type = matcher_list<Matcher>;
+  return std::allocate_shared<list_type>(arena_allocator<list_type>(), 
+      std::move(container));
+}
+
+template <typename Matcher, typename Container>
+std::shared_ptr<const matcher_list<Matcher>> 
+share_matchers(const Container& container) {
+  using list_type = matcher_list<Matcher>;
+  return std::allocate_shared<list_type>(arena_allocator<list_type>(), 
+      container.begin(), container.end());
+}
+
+}//namespace detail
+
 
 }//namespace lex
 #endif// _matcher_h_
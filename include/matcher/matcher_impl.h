@@ -1,6 +1,8 @@
 #ifndef _matcher_impl_h_
 #define _matcher_impl_h_
 
+#include "automaton/program.h"
+#include "data_structures/arena.h"
 #include "regex_types.h"
 
 #include <memory>
@@ -8,23 +10,35 @@
 namespace lex {
 // A matcher_impl object manages the state transitions for the 
 // matcher class. It does the work for both the update() and initialize()
-// methods.
+// methods. Every matcher_impl, including every clone, is allocated from
+// the arena current on its thread, if any (see data_structures/arena.h).
 template <typename CharT, typename Traits>
 class matcher_impl {
  public:
   using value_type = CharT;
   using traits_type = Traits;
-  using pointer = std::unique_ptr<matcher_impl>;
+  using pointer = arena_unique_ptr<matcher_impl>;
+  using builder_type = program_builder<CharT, Traits>;
 
   matcher_impl() = default;
-  ~matcher_impl() = default;
+  virtual ~matcher_impl() = default;
 
   virtual match_state 
   update(value_type ch) {return match_state::MISMATCH;}
   virtual match_state 
   initialize() {return match_state::FINAL_MATCH;}
   virtual pointer
-  clone() const {return std::make_unique<matcher_impl>();}
+  clone() const {return make_arena_unique<matcher_impl>();}
+  // This tells whether the other matcher would respond to every input as
+  // this one does. Both must be copies of the same original matcher, so
+  // an implementation may cast other to its own type. A false answer is
+  // always safe; it only means the two are kept apart.
+  virtual bool
+  same_state(const matcher_impl& other) const {return false;}
+  // This appends the flat program equivalent of the matcher's initial 
+  // state. The empty matcher contributes no instructions.
+  virtual void
+  emit(builder_type& builder) const {}
 };
 
 // This bit of CRTP automatically correctly defines the clone
@@ -35,7 +49,7 @@ class matcher_impl_cloner : public matcher_impl<CharT, Traits> {
   using typename matcher_impl<CharT, Traits>::pointer;
 
   pointer clone() const override {
-    return std::make_unique<Derived>(static_cast<Derived const&>(*this));
+    return make_arena_unique<Derived>(static_cast<Derived const&>(*this));
   }
 };
 
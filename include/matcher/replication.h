@@ -4,8 +4,11 @@
 #include "matcher/matcher.h"
 
 #include <cstddef>
-#include <list>
+#include <algorithm>
+#include <limits>
+#include <memory>
 #include <utility>
+#include <vector>
 
 namespace lex {
 namespace detail {
@@ -21,39 +24,64 @@ class matcher_replicator_impl
   using value_type = typename Matcher::value_type;
   using index_type = std::size_t;
   using current_progress = std::pair<matcher_type, index_type>;
+  using builder_type = typename Matcher::builder_type;
 
   matcher_replicator_impl(matcher_type&& reg, replication_data rep)
     : lower {rep.lower},
       upper {rep.upper},
-      matcher {std::move(reg)} {}
+      matcher {std::allocate_shared<matcher_type>(
+          arena_allocator<matcher_type>(), std::move(reg))} {}
   matcher_replicator_impl(const matcher_type& reg, replication_data rep)
     : lower {rep.lower},
       upper {rep.upper},
-      matcher {reg} {}
+      matcher {std::allocate_shared<matcher_type>(
+          arena_allocator<matcher_type>(), reg)} {}
     
   match_state update(value_type ch) override;
   match_state initialize() override;
+  void emit(builder_type& builder) const override;
+  bool same_state(const matcher_impl<value_type, 
+      typename matcher_type::traits_type>& other) const override {
+    auto& that = static_cast<const matcher_replicator_impl&>(other);
+    return lower == that.lower && same_progress(current, that.current);
+  }
  private:
+  using progress_list = detail::progress_list<matcher_type>;
+
   std::size_t lower;
   std::size_t upper;
-  matcher_type matcher;
-  std::list<current_progress> current;
+  // The replicated matcher in its initial state is shared by every clone.
+  std::shared_ptr<const matcher_type> matcher;
+  // Each progression counts the copies of the matcher it has started.
+  // The next list is built in next and then swapped in.
+  progress_list current;
+  progress_list next;
+
+  // Past the lower limit of an unbounded replication, every count acts
+  // the same, so they are all kept as one. This is what lets progressions
+  // merge.
+  index_type saturate(index_type count) const {
+    if (upper == std::numeric_limits<std::size_t>::max()) {
+      return std::min(count, std::max<index_type>(lower, 1));
+    }
+    return count;
+  }
 };
 
 template <typename Matcher>
 match_state matcher_replicator_impl<Matcher>::initialize() {
   current.clear();
 
-  auto r_state = matcher.state();
+  auto r_state = matcher->state();
 
   switch (r_state) {
   case match_state::FINAL_MATCH:
     return match_state::FINAL_MATCH;
   case match_state::UNDECIDED:
-    current.push_back(std::make_pair(matcher, 1));
+    current.push_back(std::make_pair(*matcher, 1));
     break;
   case match_state::MATCH:
-    current.push_back(std::make_pair(matcher, 1));
+    current.push_back(std::make_pair(*matcher, 1));
     lower = 0;
     break;
   case match_state::MISMATCH:
@@ -69,10 +97,10 @@ matcher_replicator_impl<Matcher>::update(value_type ch) {
   bool final_match {false};
   bool undecided {false};
 
-  for (auto it = current.begin(); it != current.end();) {
-    it->first.update(ch);
-    auto state = it->first.state();
-    auto count = it->second;
+  for (auto& progress : current) {
+    progress.first.update(ch);
+    auto state = progress.first.state();
+    auto count = progress.second;
 
     switch (state) {
     // If another matcher is available, we spawn a parallel progression.
@@ -84,9 +112,9 @@ matcher_replicator_impl<Matcher>::update(value_type ch) {
         undecided = true;
       }
       if (count != upper) {
-        current.insert(it, std::make_pair(matcher, count + 1));
+        add_progress(next, *matcher, saturate(count + 1));
       }
-      ++it;
+      add_progress(next, std::move(progress.first), count);
       break;
     case match_state::FINAL_MATCH:
       if (lower <= count && count < upper) {
@@ -97,21 +125,21 @@ matcher_replicator_impl<Matcher>::update(value_type ch) {
         undecided = true;
       }
       if (count != upper) {
-        (it->first).initialize();
-        ++(it->second);
+        progress.first.initialize();
+        add_progress(next, std::move(progress.first), saturate(count + 1));
       }
-      ++it;
       break;
     // A MISMATCH state is detached.
     case match_state::MISMATCH:
-      it = current.erase(it);
       break;
     default:
       undecided = true;
-      ++it;
+      add_progress(next, std::move(progress.first), count);
       break;
     }
   }
+  current.swap(next);
+  next.clear();
   if (match) {
     return match_state::MATCH;
   } else if (final_match && undecided) {
@@ -124,6 +152,54 @@ matcher_replicator_impl<Matcher>::update(value_type ch) {
     return match_state::MISMATCH;
   }
 }
+// The operand is copied once for each required repetition. An unbounded 
+// upper limit loops back over the last copy:
+//  L1: <matcher>
+//      SPLIT L1, L2
+//  L2:
+// A bounded upper limit adds nested optional copies, each of which skips
+// to the end of the whole replication:
+//      SPLIT L1, L3
+//  L1: <matcher>
+//      SPLIT L2, L3
+//  L2: <matcher>
+//  L3:
+template <typename Matcher>
+void matcher_replicator_impl<Matcher>::emit(builder_type& builder) const {
+  using index_type = typename builder_type::index_type;
+  const auto unbounded = std::numeric_limits<std::size_t>::max();
+
+  if (upper < lower) return;
+
+  for (std::size_t count = 1; count < lower; ++count) {
+    matcher->emit(builder);
+  }
+  if (upper == unbounded) {
+    if (lower == 0) {
+      auto loop = builder.emit_split(builder.position() + 1, 0);
+      matcher->emit(builder);
+      builder.emit_jump(loop);
+      builder.patch_y(loop, builder.position());
+    } else {
+      auto loop = builder.position();
+      matcher->emit(builder);
+      builder.emit_split(loop, builder.position() + 1);
+    }
+    return;
+  }
+  if (lower != 0) {
+    matcher->emit(builder);
+  }
+
+  std::vector<index_type> splits;
+  for (auto count = lower; count < upper; ++count) {
+    splits.push_back(builder.emit_split(builder.position() + 1, 0));
+    matcher->emit(builder);
+  }
+  for (auto split : splits) {
+    builder.patch_y(split, builder.position());
+  }
+}
 }//namespace detail
 
 template <typename Matcher>
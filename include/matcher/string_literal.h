@@ -16,6 +16,7 @@ class string_matcher_impl
   using traits_type = Traits;
   using string_type = typename Traits::string_type;
   using size_type = typename string_type::size_type;
+  using builder_type = program_builder<value_type, Traits>;
 
   string_matcher_impl(Iterator begin, Iterator end, const Traits& tr)
     : string(begin, end),
@@ -29,6 +30,11 @@ class string_matcher_impl
 
   match_state update(value_type t) override;
   match_state initialize() override;
+  void emit(builder_type& builder) const override;
+  bool same_state(const matcher_impl<value_type, Traits>& other) 
+    const override {
+    return current == static_cast<const string_matcher_impl&>(other).current;
+  }
  private:
   string_type string;
   size_type current;
@@ -54,6 +60,14 @@ match_state string_matcher_impl<Iterator, Traits>::initialize() {
   return string.empty()? match_state::FINAL_MATCH : match_state::UNDECIDED;
 }
 
+template <typename Iterator, typename Traits>
+void 
+string_matcher_impl<Iterator, Traits>::emit(builder_type& builder) const {
+  for (auto ch : string) {
+    builder.emit_char(ch);
+  }
+}
+
 template <typename String, typename Traits>
 matcher<typename String::value_type, Traits>
 string_matcher(String&& str, const Traits& traits) {
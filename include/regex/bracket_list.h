@@ -4,18 +4,31 @@
  * A bracket_list object implements a regex bracket list, e.g. [a-c13579],
  *  []{*], or [^0-9[:alpha:]]
  * It is essentially a list of elements that either match or do not match the
- * regex. 
+ * regex.
+ *
+ * Single characters and ranges are kept as intervals. Any other element,
+ * such as [:alpha:], is kept as a predicate. combine() compiles the list
+ * into a single predicate that does not call the elements at all:
+ *  - for characters of one byte, a bitmap of the 256 byte values;
+ *  - for wider characters, a sorted table of disjoint intervals, searched
+ *    by binary search. The elements that are not intervals are only
+ *    called when there are any.
+ * Negation is folded into the bitmap or table whenever it can be. Under
+ * icase the other cases of every listed character are added to the bitmap
+ * or table, so matching costs the same as without it.
  *
  * Types:
- *  ElementT is the template parameter and represents a single bracket 
- *    element such as x, [.ch.], [:alnum:], or 1-5.
- *  element_type = ElementT.
+ *  CharT is the template parameter and is the character type.
+ *  element_type is the type of a predicate element such as [:alnum:].
  *  bracket_type is the type representing an element of the larger regex.
  *
  * Public methods:
- *  set_matching(bool) sets the flag that determines whether we have a 
+ *  set_matching(bool) sets the flag that determines whether we have a
  *    matching or non-matching bracket.
- *  add_element(element_type) adds an element to the list.
+ *  add_char(char_type) and add_range(char_type, char_type) add characters.
+ *  add_element(element_type) adds a predicate element to the list.
+ *  set_icase(facet) makes each character match its other cases. Elements
+ *    are expected to be case insensitive already.
  *  combine() returns an element that can be used in a larger regex.
  *
  */
@@ -23,55 +36,245 @@
 #ifndef _bracket_list_h_
 #define _bracket_list_h_
 
+#include "data_structures/byte_set.h"
 #include "regex_types.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <locale>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace lex {
-  
-template <typename ElementT>
+namespace detail {
+
+// A set of characters as closed intervals. Once normalized the intervals
+// are sorted, disjoint and not adjacent, which contains() and complement()
+// require.
+template <typename CharT>
+class interval_set {
+ public:
+  using char_type = CharT;
+
+  bool empty() const {return lowers.empty();}
+  void insert(char_type lower, char_type upper) {
+    lowers.push_back(lower);
+    uppers.push_back(upper);
+  }
+  void clear() {
+    lowers.clear();
+    uppers.clear();
+  }
+
+  void normalize();
+  void complement();
+  // This adds the other cases of every character. The set is normalized
+  // afterward.
+  void fold_case(const std::ctype<char_type>& facet);
+  bool contains(char_type ch) const;
+ private:
+  std::vector<char_type> lowers;
+  std::vector<char_type> uppers;
+};
+
+template <typename CharT>
+void interval_set<CharT>::normalize() {
+  std::vector<std::pair<char_type, char_type>> intervals;
+  for (std::size_t i = 0; i != lowers.size(); ++i) {
+    intervals.emplace_back(lowers[i], uppers[i]);
+  }
+  std::sort(intervals.begin(), intervals.end());
+  clear();
+  for (const auto& interval : intervals) {
+    // The second test cannot underflow, since the interval is sorted after
+    // one that ends below it.
+    if (!lowers.empty() && (interval.first <= uppers.back() ||
+          char_type(interval.first - 1) == uppers.back())) {
+      uppers.back() = std::max(uppers.back(), interval.second);
+    } else {
+      insert(interval.first, interval.second);
+    }
+  }
+}
+
+template <typename CharT>
+void interval_set<CharT>::complement() {
+  interval_set gaps;
+  auto lower = std::numeric_limits<char_type>::lowest();
+  for (std::size_t i = 0; i != lowers.size(); ++i) {
+    if (lowers[i] > lower) {
+      gaps.insert(lower, char_type(lowers[i] - 1));
+    }
+    if (uppers[i] == std::numeric_limits<char_type>::max()) {
+      swap(lowers, gaps.lowers);
+      swap(uppers, gaps.uppers);
+      return;
+    }
+    lower = char_type(uppers[i] + 1);
+  }
+  gaps.insert(lower, std::numeric_limits<char_type>::max());
+  swap(lowers, gaps.lowers);
+  swap(uppers, gaps.uppers);
+}
+
+// Each interval is mapped a block at a time by the array forms of
+// tolower() and toupper(), so a wide range costs one call per block rather
+// than two inserts per character. Only characters with another case add
+// anything, and consecutive cases are gathered into one interval, so that
+// A-Z adds a-z as a single interval.
+template <typename CharT>
+void interval_set<CharT>::fold_case(const std::ctype<char_type>& facet) {
+  normalize();
+  constexpr std::size_t block_size {256};
+  char_type block[block_size];
+  char_type cases[block_size];
+  // The lower and the upper cases are gathered apart, since each forms
+  // runs of its own.
+  interval_set folded[2];
+  auto fold_block = [&] (std::size_t n, bool upper) {
+    auto& runs = folded[upper];
+    std::copy(block, block + n, cases);
+    if (upper) {
+      facet.toupper(cases, cases + n);
+    } else {
+      facet.tolower(cases, cases + n);
+    }
+    for (std::size_t j = 0; j != n; ++j) {
+      if (cases[j] == block[j]) continue;
+      if (!runs.empty() &&
+          runs.uppers.back() != std::numeric_limits<char_type>::max() &&
+          char_type(runs.uppers.back() + 1) == cases[j]) {
+        runs.uppers.back() = cases[j];
+      } else {
+        runs.insert(cases[j], cases[j]);
+      }
+    }
+  };
+  for (std::size_t i = 0; i != lowers.size(); ++i) {
+    for (auto ch = lowers[i];; ++ch) {
+      std::size_t n {0};
+      for (;; ++ch) {
+        block[n++] = ch;
+        if (ch == uppers[i] || n == block_size) break;
+      }
+      fold_block(n, false);
+      fold_block(n, true);
+      if (ch == uppers[i]) break;
+    }
+  }
+  for (const auto& runs : folded) {
+    lowers.insert(lowers.end(), runs.lowers.begin(), runs.lowers.end());
+    uppers.insert(uppers.end(), runs.uppers.begin(), runs.uppers.end());
+  }
+  normalize();
+}
+
+// The search finds the last interval starting at or below ch. Its loop
+// has a fixed trip count for a given table and the comparison only picks
+// between two pointers, so the compiler need not emit a branch for it.
+template <typename CharT>
+bool interval_set<CharT>::contains(char_type ch) const {
+  if (lowers.empty()) {
+    return false;
+  }
+  auto base = lowers.data();
+  for (auto n = lowers.size(); n > 1; n -= n / 2) {
+    base = base[n / 2] <= ch? base + n / 2 : base;
+  }
+  auto i = base - lowers.data();
+  return lowers[i] <= ch && ch <= uppers[i];
+}
+
+}//namespace detail
+
+template <typename CharT>
 class bracket_list {
  public:
-  using element_type = ElementT;
+  using char_type = CharT;
+  using element_type = predicate_type_t<CharT>;
   using bracket_type = element_type;
-  
+
   bracket_list(): matching {true} {}
 
   void set_matching(bool b) {matching = b;}
 
+  void add_char(char_type ch) {ranges.insert(ch, ch);}
+  void add_range(char_type lower, char_type upper) {
+    ranges.insert(lower, upper);
+  }
   void add_element(const element_type& pred) {elements.push_back(pred);}
   void add_element(element_type&& pred) {elements.push_back(std::move(pred));}
+  // The facet is only used by combine().
+  void set_icase(const std::ctype<char_type>& facet) {folding = &facet;}
+
+  bracket_type combine() const {
+    return combine(std::integral_constant<bool, sizeof(char_type) == 1>{});
+  }
 
-  bracket_type combine() const {return matching? any_of(): none_of();}
-  
-  void clear() {matching = true; elements.clear();}
+  void clear() {
+    matching = true;
+    folding = nullptr;
+    ranges.clear();
+    elements.clear();
+  }
  private:
   bool matching {true};
+  const std::ctype<char_type>* folding {nullptr};
+  detail::interval_set<char_type> ranges;
   std::vector<element_type> elements;
 
-  element_type any_of() const;
-  element_type none_of() const;
+  bracket_type combine(std::true_type) const;
+  bracket_type combine(std::false_type) const;
 };
 
-// This combines the element elements of a matching list.
-template <typename ElementT>
-typename bracket_list<ElementT>::element_type
-bracket_list<ElementT>::any_of() const {
-  return [els = this->elements] (const auto& ch) {
-    return std::any_of(els.begin(), els.end(),
-        [&ch](const auto& p) {return p(ch);});
+// Every element is evaluated once for each byte value, here, and never
+// again.
+template <typename CharT>
+typename bracket_list<CharT>::bracket_type
+bracket_list<CharT>::combine(std::true_type) const {
+  auto set = ranges;
+  if (folding) {
+    set.fold_case(*folding);
+  } else {
+    set.normalize();
+  }
+  detail::byte_set bytes;
+  for (std::size_t b = 0; b != 256; ++b) {
+    auto ch = static_cast<char_type>(static_cast<unsigned char>(b));
+    if (set.contains(ch) || std::any_of(elements.begin(), elements.end(),
+          [ch](const auto& p) {return p(ch);})) {
+      bytes.insert(static_cast<unsigned char>(b));
+    }
+  }
+  if (!matching) {
+    bytes.invert();
+  }
+  return [bytes] (char_type ch) {
+    return bytes.contains(static_cast<unsigned char>(ch));
   };
 }
 
-// This combines the element elements of a non-matching list.
-template <typename ElementT>
-typename bracket_list<ElementT>::element_type
-bracket_list<ElementT>::none_of() const {
-  return [els = this->elements] (const auto& ch) {
-    return std::none_of(els.begin(), els.end(),
-        [&ch](const auto& p) {return p(ch);});
+template <typename CharT>
+typename bracket_list<CharT>::bracket_type
+bracket_list<CharT>::combine(std::false_type) const {
+  auto set = ranges;
+  if (folding) {
+    set.fold_case(*folding);
+  } else {
+    set.normalize();
+  }
+  if (elements.empty()) {
+    if (!matching) {
+      set.complement();
+    }
+    return [set] (char_type ch) {return set.contains(ch);};
+  }
+  return [set, els = this->elements, m = matching] (char_type ch) {
+    auto found = set.contains(ch) || std::any_of(els.begin(), els.end(),
+        [ch](const auto& p) {return p(ch);});
+    return found == m;
   };
 }
 
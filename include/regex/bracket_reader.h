@@ -1,34 +1,156 @@
+/*
+ * A bracket_reader reads the tokens of a bracket expression, after its
+ * L_BRACKET, and collects them in a bracket_list. The list is compiled into
+ * a single predicate_matcher once the R_BRACKET is read.
+ *
+ * A collating element [.x.] or an equivalence class [=x=] must name a
+ * single character, which then stands for itself. Under icase the list
+ * folds case when it is compiled.
+ */
+
 #ifndef _bracket_reader_h_
 #define _bracket_reader_h_
 
+#include "bracket_list.h"
+#include "error_tracker.h"
+#include "matcher/atomic.h"
+#include "matcher/ctype_table.h"
 #include "matcher/matcher.h"
+#include "data_structures/optional.h"
 #include "regex_types.h"
+#include "data_structures/simple_buffer.h"
 #include "token_source.h"
 
+#include <locale>
+
 namespace lex {
 
 template <typename Source>
 class bracket_reader : public regex_constants {
  public:
   using char_type = typename Source::value_type;
-  using matcher_type = matcher<char_type, typename Source::traits_type>;
+  using traits_type = typename Source::traits_type;
+  using matcher_type = matcher<char_type, traits_type>;
+  using source_type = buffered<token_source<Source>>;
 
-  bracket_reader(token_source<Source>& src, syntax_option_type syntax)
+  bracket_reader(source_type& src, error_tracker t, syntax_option_type syntax)
     : source {src},
+      tracker {t},
       flag {syntax} {}
 
+  // Pre: The L_BRACKET has been read.
+  // Post: The R_BRACKET has been read, unless an error is set.
   optional<matcher_type> read();
 
  private:
-  token_source<Source>& source;
+  using value_type = typename source_type::value_type;
+  using string_type = typename traits_type::string_type;
+
+  source_type& source;
+  error_tracker tracker;
   syntax_option_type flag;
+  bracket_list<char_type> list;
+
+  optional<char_type> get_char(const value_type& token);
+  optional<char_type> get_collating_element(const string_type& name);
+  bool add_class(const string_type& name);
+  bool add_element(const value_type& token);
 };
 
 template <typename Source>
-optional<typename bracket_reader<Source>::matcher_type> 
+optional<typename bracket_reader<Source>::matcher_type>
 bracket_reader<Source>::read() {
+  auto loc = source.get_traits().getloc();
+  if (flag & syntax_option_type::icase) {
+    list.set_icase(std::use_facet<std::ctype<char_type>>(loc));
+  }
+  for (auto token = source.get(); token; token = source.get()) {
+    switch (token->type) {
+    case token_type::R_BRACKET:
+      return predicate_matcher<char_type, traits_type>(list.combine());
+    case token_type::NEGATION:
+      list.set_matching(false);
+      break;
+    case token_type::CLASS:
+      if (!add_class(token->str)) return {};
+      break;
+    default:
+      if (!add_element(*token)) return {};
+      break;
+    }
+  }
+  if (tracker.no_error()) {
+    tracker.set_error(error_type::error_brack);
+  }
   return {};
 }
 
+// This adds a character, or a range if a RANGE_DASH follows it.
+template <typename Source>
+bool bracket_reader<Source>::add_element(const value_type& token) {
+  auto lower = get_char(token);
+  if (!lower) return false;
+
+  auto dash = source.get();
+  if (!dash || dash->type != token_type::RANGE_DASH) {
+    if (dash) {
+      source.putback(*dash);
+    }
+    list.add_char(*lower);
+    return true;
+  }
+
+  auto upper_token = source.get();
+  if (!upper_token) return false;
+  auto upper = get_char(*upper_token);
+  if (!upper) return false;
+  if (*upper < *lower) {
+    tracker.set_error(error_type::error_range);
+    return false;
+  }
+  list.add_range(*lower, *upper);
+  return true;
+}
+
+template <typename Source>
+optional<typename bracket_reader<Source>::char_type>
+bracket_reader<Source>::get_char(const value_type& token) {
+  switch (token.type) {
+  case token_type::BRACKET_LITERAL:
+  case token_type::RANGE_DASH:
+    return token.ch;
+  case token_type::COLLATE:
+  case token_type::EQUIV:
+    return get_collating_element(token.str);
+  default:
+    tracker.set_error(error_type::error_range);
+    return {};
+  }
+}
+
+template <typename Source>
+optional<typename bracket_reader<Source>::char_type>
+bracket_reader<Source>::get_collating_element(const string_type& name) {
+  auto element = source.get_traits().lookup_collatename(name.begin(),
+      name.end());
+  if (element.size() != 1) {
+    tracker.set_error(error_type::error_collate);
+    return {};
+  }
+  return element.front();
+}
+
+template <typename Source>
+bool bracket_reader<Source>::add_class(const string_type& name) {
+  auto table = ctype_table<char_type>::get(source.get_traits(), name,
+      (flag & syntax_option_type::icase) != 0);
+  if (!table) {
+    tracker.set_error(error_type::error_ctype);
+    return false;
+  }
+  list.add_element([table] (char_type ch) {return table->is(ch);});
+  return true;
+}
+
 }//namespace lex
 #endif// _bracket_reader_h_
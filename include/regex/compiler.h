@@ -5,6 +5,7 @@
 #ifndef _compiler_h_
 #define _compiler_h_
 
+#include "automaton/program.h"
 #include "matcher/atomic.h"
 #include "matcher/alternation.h"
 #include "matcher/concatenation.h"
@@ -15,6 +16,7 @@
 #include "bracket_reader.h"
 #include "compiler_impl.h"
 #include "error_tracker.h"
+#include "data_structures/arena.h"
 #include "data_structures/optional.h"
 #include "regex_types.h"
 #include "data_structures/simple_buffer.h"
@@ -23,6 +25,7 @@
 #include "syntax_option.h"
 
 #include "project_assert.h"
+#include <cstddef>
 #include <iterator>
 #include <utility>
 #include <vector>
@@ -36,18 +39,28 @@ class compiler : public regex_constants {
   using traits_type = typename Source::traits_type;
   using matcher_type = matcher<value_type, traits_type>;
   using string_type = typename traits_type::string_type;
-
-  compiler(Source& src, error_type& er, syntax_option_type f)
-    : impl(src, er, f)
+  using program_type = program<value_type, traits_type>;
+
+  // The matchers built while compiling come from the given arena, which
+  // defaults to the arena current on this thread, if any.
+  compiler(Source& src, error_type& er, syntax_option_type f,
+      arena* region = current_arena())
+    : impl(src, er, f),
+      region_ {region}
   //, source(src, er, f)
   //, tracker(er)
   //, syntax_ (f) 
   {}
 
+  // The matcher returned must not outlive the compiler's arena.
   optional<matcher_type> compile();
+  // This compiles the regex into a flat program with a single MATCH 
+  // instruction for the given rule.
+  optional<program_type> compile_program(std::size_t rule = 0);
 
  private:
   compiler_impl<Source> impl;
+  arena* region_;
   //buffered<token_source<Source>> source;
   //error_tracker tracker;
   //syntax_option_type syntax_;
@@ -71,9 +84,23 @@ class compiler : public regex_constants {
 template <typename Source>
 optional<typename compiler<Source>::matcher_type>
 compiler<Source>::compile() {
+  arena_scope scope(region_);
   return impl.get_alternation();
 }
 
+template <typename Source>
+optional<typename compiler<Source>::program_type>
+compiler<Source>::compile_program(std::size_t rule) {
+  arena_scope scope(region_);
+  auto matcher = impl.get_alternation();
+  if (!matcher) return {};
+
+  program_builder<value_type, traits_type> builder;
+  matcher->emit(builder);
+  builder.emit_match(rule);
+  return builder.release();
+}
+
 /*
 template <typename Source>
 optional<typename compiler<Source>::matcher_type>
@@ -12,6 +12,7 @@
 #include "matcher/replication.h"
 #include "matcher/string_literal.h"
 
+#include "bracket_list.h"
 #include "bracket_reader.h"
 #include "error_tracker.h"
 #include "data_structures/optional.h"
@@ -21,6 +22,7 @@
 
 #include "project_assert.h"
 #include <iterator>
+#include <locale>
 #include <utility>
 #include <vector>
 
@@ -46,6 +48,7 @@ class compiler_impl : public regex_constants {
   optional<matcher_type> get_bracket();
   optional<matcher_type> get_subexpression();
   optional<replication_data> get_replication();
+  matcher_type get_folded_string(const string_type& str);
 
   const traits_type& get_traits() const {return source.get_traits();}
 
@@ -56,7 +59,7 @@ class compiler_impl : public regex_constants {
 
   bool eat_token(token_type);
 
-  using matcher_list = std::vector<matcher_type>;
+  using matcher_list = lex::matcher_list<matcher_type>;
   template <typename Compositor>
   matcher_type compose(matcher_list&& elements, 
       Compositor compositor);
@@ -70,7 +73,7 @@ compiler_impl<Source>::get_alternation() {
 
   if (source.empty()) return {};
 
-  std::vector<matcher_type> branches;
+  matcher_list branches;
   
   for (auto br = get_branch(); br; br = get_branch()) {
     branches.push_back(move(*br));
@@ -98,7 +101,7 @@ compiler_impl<Source>::get_branch() {
 
   if (source.empty()) return {};
 
-  std::vector<matcher_type> expressions;
+  matcher_list expressions;
   for (auto exp = get_expression(); exp; exp = get_expression()) {
     expressions.push_back(*exp);
   }
@@ -156,12 +159,17 @@ compiler_impl<Source>::get_element() {
 
   case token_type::CHAR_CLASS:
     return character_class_matcher<value_type,traits_type>(token->ch,
-        get_traits());
+        get_traits(), (syntax_ & icase) != 0);
 
   case token_type::STRING_LITERAL:
+    if (syntax_ & icase) {
+      return get_folded_string(token->str);
+    }
     return string_matcher(std::move(token->str), get_traits());
   default:
-//  ALTERNATION 
+    // ALTERNATION and R_PAREN end the current branch. They are left for
+    // get_alternation() and get_subexpression() to consume.
+    source.putback(*token);
     return {};
   }
 }
@@ -209,14 +217,50 @@ compiler_impl<Source>::get_subexpression() {
 template <typename Source>
 optional<typename compiler_impl<Source>::matcher_type> 
 compiler_impl<Source>::get_bracket() {
-  bracket_reader<Source> brack_reader(source, syntax_);
+  bracket_reader<Source> brack_reader(source, tracker, syntax_);
   return brack_reader.read();
 }
 
+// Under icase each character with other cases becomes a bracket of all
+// its cases, e.g. "if" becomes [iI][fF], so the automaton needs no case
+// folding at run time. Each bracket records the lower case it stands for,
+// so the string is still seen as a literal. Runs of characters without
+// case stay strings.
+template <typename Source>
+typename compiler_impl<Source>::matcher_type
+compiler_impl<Source>::get_folded_string(const string_type& str) {
+  using std::move;
+  auto loc = get_traits().getloc();
+  const auto& facet = std::use_facet<std::ctype<value_type>>(loc);
+  matcher_list elements;
+  string_type run;
+  for (auto ch : str) {
+    if (facet.tolower(ch) == ch && facet.toupper(ch) == ch) {
+      run.push_back(ch);
+      continue;
+    }
+    if (!run.empty()) {
+      elements.push_back(string_matcher(move(run), get_traits()));
+      run.clear();
+    }
+    bracket_list<value_type> list;
+    list.set_icase(facet);
+    list.add_char(ch);
+    elements.push_back(predicate_matcher<value_type, traits_type>(
+          list.combine(), facet.tolower(ch)));
+  }
+  if (!run.empty()) {
+    elements.push_back(string_matcher(move(run), get_traits()));
+  }
+  return compose(move(elements), [](auto&& vec) {
+        return lex::concatenate(std::forward<matcher_list>(vec));
+      });
+}
+
 template <typename Source>
 template <typename Compositor>
 typename compiler_impl<Source>::matcher_type
-compiler_impl<Source>::compose(std::vector<matcher_type>&& elements,
+compiler_impl<Source>::compose(matcher_list&& elements,
     Compositor compositor) {
   using std::move;
   // The first alternative probably always indicates an error in the regex.
@@ -32,7 +32,9 @@ class expression_interpreter : public regex_constants {
  private:
   character_interpreter<Source> interpreter;
   brace_interpreter<Source> brace_reader;
-  simple_buffer<value_type> buffer;
+  // The token after a string literal, and its last character when that
+  // token is a quantifier.
+  simple_buffer<value_type, unsigned char, 2> buffer;
 
   optional<value_type> get_token();
 };
@@ -89,6 +91,14 @@ expression_interpreter<Source>::get() {
   if (value) {
     buffer.push(*value);
   }
+  // A quantifier applies only to the character before it, so "ab*" is a
+  // followed by b*. That character is read again as a literal of its own.
+  bool quantified {value && (value->type == token_type::REPLICATION ||
+        value->type == token_type::L_BRACE)};
+  if (quantified && string_literal.size() > 1) {
+    buffer.push(value_type(string_literal.back(), token_type::LITERAL));
+    string_literal.pop_back();
+  }
 
   return value_type(string_literal, token_type::STRING_LITERAL);
 }
@@ -8,15 +8,21 @@
 #ifndef _regex_h_
 #define _regex_h_
 
+#include "automaton/bit_parallel.h"
+#include "automaton/literal_search.h"
+#include "automaton/program.h"
 #include "character_source.h"
 #include "compiler.h"
+#include "regex_state.h"
 
 #include <cstddef>
 #include <cstring>
 #include <initializer_list>
 #include <iterator>
+#include <memory>
 #include <regex>
 #include <string>
+#include <utility>
 
 namespace lex {
 
@@ -29,6 +35,13 @@ class regex {
   using locale_type = typename Traits::locale_type;
   using flag_type = regex_constants::syntax_option_type;
   using error_type = regex_constants::error_type;
+  using program_type = program<CharT, Traits>;
+  // A state_type holds everything that changes while matching. The compiled
+  // program itself is never modified and is shared by all copies of a regex.
+  // A program with at most 64 positions is run bit-parallel, any other by
+  // a lazy DFA.
+  using state_type = regex_state<CharT, Traits>;
+  using parallel_table = bit_parallel_table<CharT, Traits>;
 
   static const flag_type default_flag = flag_type::extended;
   static const flag_type icase = flag_type::icase;
@@ -45,7 +58,13 @@ class regex {
   
   //Constructors
   regex() = default;
-  regex(const regex& other) = default;
+  regex(const regex& other)
+    : program_ {other.program_},
+      parallel_ {other.parallel_},
+      prefix_ {other.prefix_},
+      traits_i {other.traits_i},
+      f_ {other.f_},
+      ec {other.ec} {}
   regex(regex&& other) = default;
 
   explicit regex(const CharT* s, flag_type f = default_flag)
@@ -67,7 +86,7 @@ class regex {
   ~regex() = default;
 
   // Operator=
-  regex& operator=(const regex& other) = default;
+  regex& operator=(const regex& other);
   regex& operator=(regex&& other) = default;
   regex& operator=(CharT* s) {return this->assign(s);}
   regex& operator=(std::initializer_list<CharT> init) {
@@ -111,10 +130,39 @@ class regex {
   locale_type getloc() const {return traits_i.getloc();}
   locale_type imbue(locale_type loc) {return traits_i.imbue(loc);}
 
+  // The compiled program always ends with a single MATCH instruction.
+  const program_type& get_program() const {return *program_;}
+
+  // This creates fresh run state for this regex. A state may be reused for
+  // any number of matches, and it keeps its cached DFA states between them.
+  state_type make_state() const {return state_type(program_, parallel_);}
+
+  // These return the end of the longest match at the start of the range,
+  // or begin if nothing matches. The first overload uses run state owned
+  // by this regex, which is created on first use and never copied. The
+  // state given to the second must come from this regex or from a copy.
   template <typename ForwardIt>
   ForwardIt match(ForwardIt begin, ForwardIt end);
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end, state_type& state) const;
+
+  // These return the first nonempty match in the range, or (end, end) if
+  // there is none. If every match starts with the same literal, only the
+  // positions where that literal occurs are tried.
+  template <typename ForwardIt>
+  std::pair<ForwardIt, ForwardIt> search(ForwardIt begin, ForwardIt end);
+  template <typename ForwardIt>
+  std::pair<ForwardIt, ForwardIt> search(ForwardIt begin, ForwardIt end,
+      state_type& state) const;
+
+  // This is the literal that every match starts with. It may be empty.
+  const string_type& prefix() const {return prefix_;}
  private:
-  matcher<CharT, Traits> matcher_;
+  std::shared_ptr<const program_type> program_ {empty_program()};
+  // This is null when the program is run by a lazy DFA.
+  std::shared_ptr<const parallel_table> parallel_;
+  std::unique_ptr<state_type> scratch_;
+  string_type prefix_;
   traits_type traits_i;
   flag_type f_;
   error_type ec {error_type::error_none};
@@ -125,6 +173,8 @@ class regex {
   };
 
   flag_type construct_flag(flag_type f);
+  // This program matches only the empty string.
+  static std::shared_ptr<const program_type> empty_program();
 };
 
 template <typename CharT, typename Traits>
@@ -132,37 +182,78 @@ template <typename ForwardIt>
 regex<CharT,Traits>::regex(ForwardIt first, ForwardIt last, flag_type f) 
   : f_ {construct_flag(f)} {
   auto source = make_character_source(first, last, traits_i);
-  compiler<decltype(source)> compiler(source, ec, f);
-  auto matcher_p = compiler.compile();
-  if (matcher_p) matcher_ = *matcher_p;
+  compiler<decltype(source)> compiler(source, ec, f_);
+  auto program_p = compiler.compile_program();
+  if (program_p) {
+    program_ = std::make_shared<const program_type>(std::move(*program_p));
+    parallel_ = parallel_table::build(*program_);
+    prefix_ = literal_prefix(*program_);
+  }
+}
+
+// The run state of other belongs to other, so it is not copied.
+template <typename CharT, typename Traits>
+regex<CharT,Traits>& regex<CharT,Traits>::operator=(const regex& other) {
+  program_ = other.program_;
+  parallel_ = other.parallel_;
+  scratch_.reset();
+  prefix_ = other.prefix_;
+  traits_i = other.traits_i;
+  f_ = other.f_;
+  ec = other.ec;
+  return *this;
 }
 
 template <typename CharT, typename Traits>
 template <typename ForwardIt>
 ForwardIt regex<CharT,Traits>::match(ForwardIt begin, ForwardIt end) {
-  auto accepted = begin;
-  bool loop_done {false};
-  for (auto seek = begin; !loop_done && seek != end;) {
-    matcher_.update(*seek);
-    ++seek;
-    switch (matcher_.state()) {
-    case match_state::MATCH:
-      accepted = seek;
-      break;
-    case match_state::FINAL_MATCH:
-      accepted = seek;
-      loop_done = true;
-      break;
-    case match_state::MISMATCH:
-      loop_done = true;
-      break;
-    case match_state::UNDECIDED:
-      break;
+  if (!scratch_) {
+    scratch_ = std::make_unique<state_type>(program_, parallel_);
+  }
+  return match(begin, end, *scratch_);
+}
+
+template <typename CharT, typename Traits>
+template <typename ForwardIt>
+ForwardIt regex<CharT,Traits>::match(ForwardIt begin, ForwardIt end,
+    state_type& state) const {
+  return state.match(begin, end);
+}
+
+template <typename CharT, typename Traits>
+template <typename ForwardIt>
+std::pair<ForwardIt, ForwardIt> 
+regex<CharT,Traits>::search(ForwardIt begin, ForwardIt end) {
+  if (!scratch_) {
+    scratch_ = std::make_unique<state_type>(program_, parallel_);
+  }
+  return search(begin, end, *scratch_);
+}
+
+template <typename CharT, typename Traits>
+template <typename ForwardIt>
+std::pair<ForwardIt, ForwardIt> 
+regex<CharT,Traits>::search(ForwardIt begin, ForwardIt end,
+    state_type& state) const {
+  for (auto it = begin; it != end; ++it) {
+    if (!prefix_.empty()) {
+      it = find_literal(it, end, prefix_);
+      if (it == end) break;
+    }
+    auto last = state.match(it, end);
+    if (last != it) {
+      return std::make_pair(it, last);
     }
   }
-  // The matcher needs to be reinitialized to be used again later.
-  matcher_.initialize();
-  return accepted;
+  return std::make_pair(end, end);
+}
+
+template <typename CharT, typename Traits>
+std::shared_ptr<const typename regex<CharT,Traits>::program_type>
+regex<CharT,Traits>::empty_program() {
+  program_builder<CharT, Traits> builder;
+  builder.emit_match();
+  return std::make_shared<const program_type>(builder.release());
 }
 
 template <typename CharT, typename Traits>
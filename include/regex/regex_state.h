@@ -0,0 +1,56 @@
+/*
+ * A regex_state is the run state of a regex. When the regex's program has
+ * few enough positions for a bit_parallel_table, it is run by a
+ * bit_parallel_nfa, which needs no DFA at all. Any other program is run by
+ * a lazy_dfa. The choice is made once, when the regex is compiled.
+ */
+
+#ifndef _regex_state_h_
+#define _regex_state_h_
+
+#include "automaton/bit_parallel.h"
+#include "automaton/lazy_dfa.h"
+#include "automaton/program.h"
+
+#include <memory>
+#include <utility>
+
+namespace lex {
+
+template <typename CharT, typename Traits>
+class regex_state {
+ public:
+  using program_type = program<CharT, Traits>;
+  using program_pointer = std::shared_ptr<const program_type>;
+  using table_type = bit_parallel_table<CharT, Traits>;
+  using table_pointer = std::shared_ptr<const table_type>;
+  using index_type = std::size_t;
+
+  // A null table means the program is run by a lazy DFA.
+  regex_state(program_pointer p, table_pointer t) {
+    if (t) {
+      parallel = std::make_unique<bit_parallel_nfa<CharT, Traits>>(
+          std::move(t));
+    } else {
+      lazy = std::make_unique<lazy_dfa<CharT, Traits>>(std::move(p));
+    }
+  }
+
+  bool bit_parallel() const {return parallel != nullptr;}
+
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end) {
+    return parallel? parallel->match(begin, end) : lazy->match(begin, end);
+  }
+  template <typename ForwardIt>
+  ForwardIt match(ForwardIt begin, ForwardIt end, index_type& rule) {
+    return parallel? parallel->match(begin, end, rule) :
+      lazy->match(begin, end, rule);
+  }
+ private:
+  std::unique_ptr<bit_parallel_nfa<CharT, Traits>> parallel;
+  std::unique_ptr<lazy_dfa<CharT, Traits>> lazy;
+};
+
+}//namespace lex
+#endif// _regex_state_h_
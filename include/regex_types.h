@@ -5,6 +5,7 @@
 #include <functional>
 #include <iterator>
 #include <stdexcept>
+#include <type_traits>
 
 namespace lex {
 
@@ -76,6 +77,19 @@ template <typename CharIterator>
 using value_type_t = 
   typename std::iterator_traits<CharIterator>::value_type;
 
+template <typename CharIterator>
+using char_type_t = value_type_t<CharIterator>;
+
+// These remove a template from overload resolution unless its iterator, or
+// its container, holds values of type T.
+template <typename Iterator, typename T>
+using enable_iterator_t = 
+  std::enable_if_t<std::is_convertible<value_type_t<Iterator>, T>::value>;
+
+template <typename Container, typename T>
+using enable_container_t = std::enable_if_t<std::is_convertible<
+    typename std::decay_t<Container>::value_type, T>::value>;
+
 template <typename Char>
 using predicate_type_t = std::function<bool(Char)>;
 
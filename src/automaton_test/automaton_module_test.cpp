@@ -0,0 +1,26 @@
+#include "ttest/ttest.h"
+
+ttest::test_suite::pointer create_program_test();
+ttest::test_suite::pointer create_pike_vm_test();
+ttest::test_suite::pointer create_lazy_dfa_test();
+ttest::test_suite::pointer create_bit_parallel_test();
+ttest::test_suite::pointer create_dfa_test();
+ttest::test_suite::pointer create_dfa_file_test();
+ttest::test_suite::pointer create_static_dfa_test();
+ttest::test_suite::pointer create_literal_search_test();
+ttest::test_suite::pointer create_literal_trie_test();
+
+ttest::test_suite::pointer create_automaton_module_test() {
+  using ttest::create_test;
+  return create_test("automaton", {
+      create_program_test(),
+      create_pike_vm_test(),
+      create_lazy_dfa_test(),
+      create_bit_parallel_test(),
+      create_dfa_test(),
+      create_dfa_file_test(),
+      create_static_dfa_test(),
+      create_literal_search_test(),
+      create_literal_trie_test(),
+    });
+}
@@ -0,0 +1,125 @@
+#include "automaton_test.h"
+#include "automaton/bit_parallel.h"
+#include "automaton/lazy_dfa.h"
+#include "ttest/ttest.h"
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace lex;
+
+using Traits = std::regex_traits<char>;
+using Table = bit_parallel_table<char, Traits>;
+using NFA = bit_parallel_nfa<char, Traits>;
+
+// The bit-parallel engine must find the same matches as the lazy DFA.
+void bit_parallel_match_test(ttest::error_log& log) {
+  std::vector<std::string> patterns {
+    "abc", "a(b|c)*d", "x*", "(ab|a)*c", "\\w+", "a{2,4}", "(a|b)*a(a|b){3}"
+  };
+  std::vector<std::string> inputs {
+    "", "abcd", "abcbcbd", "xxxy", "ababaabc", "word_1 x", "aaaaa",
+    "babbbabbb"
+  };
+  for (auto& pattern : patterns) {
+    auto prog = compile_shared(pattern);
+    auto table = Table::build(*prog);
+    if (!table) {
+      log.append(pattern + " not built");
+      continue;
+    }
+    NFA nfa(table);
+    lazy_dfa<char, Traits> dfa(prog);
+    for (auto& input : inputs) {
+      std::size_t nfa_rule, dfa_rule;
+      auto nfa_end = nfa.match(input.begin(), input.end(), nfa_rule);
+      auto dfa_end = dfa.match(input.begin(), input.end(), dfa_rule);
+      log.append_if(pattern + " on " + input,
+          nfa_end != dfa_end || nfa_rule != dfa_rule);
+    }
+  }
+}
+
+// After match() the state is the one that update() reaches on the
+// characters match() read, which stops when no position is active.
+void bit_parallel_state_test(ttest::error_log& log) {
+  std::vector<std::string> patterns {"x*", "ab|a", "(ab)*c?", "\\w+"};
+  std::vector<std::string> inputs {"", "b", "xxb", "abab", "abc", "ax"};
+  for (auto& pattern : patterns) {
+    auto table = Table::build(compile(pattern));
+    if (!table) {
+      log.append(pattern + " not built");
+      continue;
+    }
+    NFA matched(table);
+    NFA fed(table);
+    for (auto& input : inputs) {
+      matched.match(input.begin(), input.end());
+      fed.initialize();
+      for (auto it = input.begin(); it != input.end() &&
+          fed.state() != match_state::MISMATCH &&
+          fed.state() != match_state::FINAL_MATCH; ++it) {
+        fed.update(*it);
+      }
+      log.append_if(pattern + " on " + input + " state",
+          matched.state() != fed.state());
+      log.append_if(pattern + " on " + input + " rule",
+          matched.rule() != fed.rule());
+    }
+  }
+}
+
+// The rules are joined the same way a translator joins them.
+void bit_parallel_rule_test(ttest::error_log& log) {
+  std::vector<std::string> rules {"if", "\\w+", "\\d+"};
+  NFA nfa(Table::build(join_rules(rules)));
+
+  std::string input {"iffy"};
+  std::vector<std::size_t> expected {1, 0, 1, 1};
+  std::vector<match_state> states {
+    match_state::MATCH, match_state::MATCH, match_state::MATCH,
+    match_state::MATCH
+  };
+  nfa.initialize();
+  log.append_if("initial", nfa.state() != match_state::UNDECIDED);
+  for (auto i = 0u; i != input.size(); ++i) {
+    nfa.update(input[i]);
+    log.append_if("rule " + std::to_string(i), nfa.rule() != expected[i]);
+    log.append_if("state " + std::to_string(i), nfa.state() != states[i]);
+  }
+  nfa.update(' ');
+  log.append_if("mismatch", nfa.state() != match_state::MISMATCH);
+
+  std::size_t rule;
+  input = "42";
+  log.append_if("priority", nfa.match(input.begin(), input.end(), rule) !=
+      input.end() || rule != 1);
+}
+
+void bit_parallel_limit_test(ttest::error_log& log) {
+  log.append_if("64 positions", !Table::build(compile(std::string(64, 'a'))));
+  log.append_if("65 positions", Table::build(compile(std::string(65, 'a'))));
+
+  std::string input(63, 'a');
+  auto table = Table::build(compile(input + "|b"));
+  if (!table) {
+    log.append("not built");
+    return;
+  }
+  NFA nfa(table);
+  input += "aa";
+  log.append_if("last position",
+      nfa.match(input.begin(), input.end()) != input.begin() + 63);
+}
+
+ttest::test_suite::pointer create_bit_parallel_test() {
+  using ttest::create_test;
+  return create_test("bit_parallel", {
+      create_test("match", bit_parallel_match_test),
+      create_test("state", bit_parallel_state_test),
+      create_test("rules", bit_parallel_rule_test),
+      create_test("limit", bit_parallel_limit_test)
+  });
+}
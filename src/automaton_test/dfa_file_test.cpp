@@ -0,0 +1,120 @@
+#include "automaton_test.h"
+#include "automaton/dfa.h"
+#include "automaton/dfa_file.h"
+#include "ttest/ttest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lex;
+
+static std::size_t match_length(const dfa_view& table, 
+    const std::string& input) {
+  dfa_engine engine(table);
+  return engine.match(input.begin(), input.end()) - input.begin();
+}
+
+void dfa_file_round_trip_test(ttest::error_log& log) {
+  const std::string path {"dfa_file_test.dfa"};
+  auto table = build_dfa(compile("\\d+(\\.\\d*)?|\\w+"));
+  if (!table || !save_dfa(table->view(), path, 42)) {
+    log.append("not saved");
+    return;
+  }
+
+  mapped_dfa mapped;
+  log.append_if("wrong key", mapped.open(path, 43));
+  if (!mapped.open(path, 42)) {
+    log.append("not mapped");
+    std::remove(path.c_str());
+    return;
+  }
+  log.append_if("states", 
+      mapped.view().state_count() != table->state_count());
+  for (std::string input : {"3.25x", "abc12 ", "..", "7"}) {
+    log.append_if(input, match_length(mapped.view(), input) != 
+        match_length(table->view(), input));
+  }
+
+  mapped_dfa moved(std::move(mapped));
+  log.append_if("moved", !moved.is_open() || mapped.is_open());
+
+  // A truncated file must be rejected.
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << "lexdfa";
+  log.append_if("truncated", mapped.open(path, 42));
+  std::remove(path.c_str());
+}
+
+// Threads saving the same key at once must each write their own
+// temporary file, so whichever rename comes last leaves a whole file.
+void dfa_file_concurrent_save_test(ttest::error_log& log) {
+  const std::string path {"dfa_file_concurrent_test.dfa"};
+  auto table = build_dfa(compile("\\d+(\\.\\d*)?|\\w+|(a|b)*a(a|b){6}"));
+  if (!table) {
+    log.append("not built");
+    return;
+  }
+  bool saved[2] {true, true};
+  auto save = [&table, &path] (bool& ok) {
+    for (auto i = 0; i != 50; ++i) {
+      ok = save_dfa(table->view(), path, 42) && ok;
+    }
+  };
+  std::thread first(save, std::ref(saved[0]));
+  std::thread second(save, std::ref(saved[1]));
+  first.join();
+  second.join();
+  log.append_if("not saved", !saved[0] || !saved[1]);
+
+  mapped_dfa mapped;
+  if (!mapped.open(path, 42)) {
+    log.append("not mapped");
+    std::remove(path.c_str());
+    return;
+  }
+  for (std::string input : {"3.25x", "abc12 ", "abaabbbab", "7"}) {
+    log.append_if(input, match_length(mapped.view(), input) != 
+        match_length(table->view(), input));
+  }
+  std::remove(path.c_str());
+}
+
+void dfa_cache_test(ttest::error_log& log) {
+  std::vector<std::string> rules {"if", "\\w+"};
+  auto key = rule_set_hash(rules.begin(), rules.end(), 
+      regex_constants::ECMAScript);
+  std::vector<std::string> other {"i", "f\\w+"};
+  log.append_if("hash", key == rule_set_hash(other.begin(), other.end(),
+        regex_constants::ECMAScript));
+  log.append_if("flags", key == rule_set_hash(rules.begin(), rules.end(),
+        regex_constants::extended));
+
+  dfa_cache cache(".");
+  int builds {0};
+  auto build = [&] () {
+    ++builds;
+    return build_dfa(join_rules(rules));
+  };
+
+  mapped_dfa first;
+  mapped_dfa second;
+  log.append_if("first load", !cache.load(key, first, build));
+  log.append_if("second load", !cache.load(key, second, build));
+  log.append_if("rebuilt", builds != 1);
+  log.append_if("match", match_length(second.view(), "iffy") != 4);
+  std::remove(cache.path(key).c_str());
+}
+
+ttest::test_suite::pointer create_dfa_file_test() {
+  using ttest::create_test;
+  return create_test("dfa_file", {
+      create_test("round trip", dfa_file_round_trip_test),
+      create_test("concurrent save", dfa_file_concurrent_save_test),
+      create_test("cache", dfa_cache_test)
+  });
+}
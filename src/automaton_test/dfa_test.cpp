@@ -0,0 +1,139 @@
+#include "automaton_test.h"
+#include "automaton/dfa.h"
+#include "automaton/lazy_dfa.h"
+#include "ttest/ttest.h"
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace lex;
+
+using Traits = std::regex_traits<char>;
+
+void dfa_state_test(ttest::error_log& log) {
+  auto table = build_dfa(compile("ab|x{1,2}"));
+  if (!table) {
+    log.append("not built");
+    return;
+  }
+  dfa_engine engine(table->view());
+  std::vector<match_state> expected {
+    match_state::MATCH, match_state::FINAL_MATCH, match_state::MISMATCH
+  };
+  log.append_if("initial", engine.state() != match_state::UNDECIDED);
+  std::string input {"xxx"};
+  for (auto i = 0u; i != input.size(); ++i) {
+    engine.update(input[i]);
+    log.append_if("state " + std::to_string(i), 
+        engine.state() != expected[i]);
+  }
+}
+
+// The dfa must agree with the lazy_dfa on every prefix of random input.
+void dfa_agreement_test(ttest::error_log& log) {
+  std::vector<std::string> patterns {
+    "a*b|ab*", "(a|b)*abb", "\\w+\\s?", "c{2,4}|(ab)+", "a?b?c?"
+  };
+  unsigned seed {2017};
+  for (const auto& pattern : patterns) {
+    auto prog = compile_shared(pattern);
+    auto table = build_dfa(*prog);
+    if (!table) {
+      log.append(pattern + " not built");
+      continue;
+    }
+    dfa_engine engine(table->view());
+    lazy_dfa<char, Traits> reference(prog);
+    for (auto trial = 0; trial < 50; ++trial) {
+      std::string input;
+      for (auto i = 0; i < 12; ++i) {
+        seed = seed * 1103515245 + 12345;
+        input.push_back("abc "[(seed >> 16) % 4]);
+      }
+      if (engine.match(input.begin(), input.end()) !=
+          reference.match(input.begin(), input.end())) {
+        log.append(pattern + " on \"" + input + "\"");
+      }
+    }
+  }
+}
+
+void dfa_rule_test(ttest::error_log& log) {
+  auto table = build_dfa(join_rules({"if", "\\w+", "\\d+"}));
+  if (!table) {
+    log.append("not built");
+    return;
+  }
+  dfa_engine engine(table->view());
+  std::string input {"iffy"};
+  std::vector<std::size_t> expected {1, 0, 1, 1};
+  engine.initialize();
+  for (auto i = 0u; i != input.size(); ++i) {
+    engine.update(input[i]);
+    log.append_if("rule " + std::to_string(i), engine.rule() != expected[i]);
+  }
+  input = "42";
+  log.append_if("priority", engine.match(input.begin(), input.end()) != 
+      input.end() || engine.rule() != 1);
+  // Rows are indexed by byte class: i, f, digits, other word characters
+  // and the rest.
+  log.append_if("classes", table->view().class_count() != 5);
+}
+
+// The dfa for this pattern needs more than 512 states.
+void dfa_limit_test(ttest::error_log& log) {
+  auto prog = compile("(a|b)*a(a|b){8}c");
+  log.append_if("limit ignored", build_dfa(prog, 16).has_value());
+  log.append_if("not built", !build_dfa(prog).has_value());
+
+  dfa empty;
+  dfa_engine engine(empty.view());
+  log.append_if("empty dfa", engine.state() != match_state::MISMATCH);
+}
+
+void dfa_minimize_test(ttest::error_log& log) {
+  // The states after a and after c are equivalent. So are the two
+  // accepting states. With the dead state and the start state that makes
+  // four.
+  auto table = build_dfa(compile("ab|cb"));
+  log.append_if("ab|cb", !table || table->state_count() != 4);
+
+  // Distinct rules must not be merged, so neither may the states that
+  // lead to them.
+  table = build_dfa(join_rules({"ab", "cb"}));
+  log.append_if("rules", !table || table->state_count() != 6);
+
+  // Every state of a*(b|c)a* that has seen b or c behaves the same.
+  table = build_dfa(compile("a*(b|c)a*"));
+  log.append_if("a*(b|c)a*", !table || table->state_count() != 3);
+}
+
+// After "a" no input can lead to a match, so the dfa must stop at once.
+void dfa_prune_test(ttest::error_log& log) {
+  program_builder<char, Traits> builder;
+  builder.emit_char('a');
+  builder.emit_predicate([](char) {return false;});
+  builder.emit_match();
+  auto table = build_dfa(builder.release());
+  if (!table) {
+    log.append("not built");
+    return;
+  }
+  dfa_engine engine(table->view());
+  log.append_if("start", engine.state() != match_state::MISMATCH);
+  log.append_if("states", table->state_count() != 1);
+}
+
+ttest::test_suite::pointer create_dfa_test() {
+  using ttest::create_test;
+  return create_test("dfa", {
+      create_test("states", dfa_state_test),
+      create_test("agreement", dfa_agreement_test),
+      create_test("rules", dfa_rule_test),
+      create_test("limit", dfa_limit_test),
+      create_test("minimize", dfa_minimize_test),
+      create_test("prune", dfa_prune_test)
+  });
+}
@@ -0,0 +1,133 @@
+#include "automaton_test.h"
+#include "automaton/lazy_dfa.h"
+#include "ttest/ttest.h"
+
+#include <list>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace lex;
+
+using DFA = lazy_dfa<char, std::regex_traits<char>>;
+
+static std::size_t match_length(DFA& dfa, const std::string& input) {
+  return dfa.match(input.begin(), input.end()) - input.begin();
+}
+
+void lazy_dfa_state_test(ttest::error_log& log) {
+  DFA dfa(compile_shared("ab|x{1,2}"));
+  std::vector<match_state> expected {
+    match_state::MATCH, match_state::FINAL_MATCH, match_state::MISMATCH
+  };
+  log.append_if("initial", dfa.state() != match_state::UNDECIDED);
+  std::string input {"xxx"};
+  for (auto i = 0u; i != input.size(); ++i) {
+    dfa.update(input[i]);
+    log.append_if("state " + std::to_string(i), dfa.state() != expected[i]);
+  }
+}
+
+void lazy_dfa_cache_test(ttest::error_log& log) {
+  DFA dfa(compile_shared("\\d*|\\w+"));
+  log.append_if("first", match_length(dfa, "abc12 ") != 5);
+  auto count = dfa.state_count();
+  log.append_if("second", match_length(dfa, "cab21 ") != 5);
+  log.append_if("states were not reused", dfa.state_count() != count);
+  log.append_if("flushed", dfa.flush_count() != 0);
+}
+
+// The DFA for this pattern needs a state for every combination of the last
+// nine characters, so a small cache thrashes.
+void lazy_dfa_fallback_test(ttest::error_log& log) {
+  DFA dfa(compile_shared("(a|b)*a(a|b){8}c"), 16);
+  std::string input;
+  unsigned seed {12345};
+  for (auto i = 0u; i < 2000; ++i) {
+    seed = seed * 1103515245 + 12345;
+    input.push_back((seed >> 16) & 1? 'a' : 'b');
+  }
+  auto tail = input.substr(input.size() - 20) + "aabababab";
+  log.append_if("mismatch", match_length(dfa, input) != 0);
+  log.append_if("not flushed", dfa.flush_count() == 0);
+  log.append_if("not using nfa", !dfa.using_nfa());
+  log.append_if("nfa match", match_length(dfa, tail + "c") != 30);
+
+  lazy_dfa<wchar_t, std::regex_traits<wchar_t>> wide(compile_shared(L"a+"));
+  std::wstring winput {L"aab"};
+  log.append_if("wide chars are cached", !wide.using_nfa());
+  log.append_if("wide match",
+      wide.match(winput.begin(), winput.end()) != winput.begin() + 2);
+}
+
+// The rules are joined the same way a translator joins them.
+void lazy_dfa_rule_test(ttest::error_log& log) {
+  using Traits = std::regex_traits<char>;
+  std::vector<std::string> rules {"if", "\\w+", "\\d+"};
+  DFA dfa(std::make_shared<const program<char, Traits>>(join_rules(rules)));
+
+  std::string input {"iffy"};
+  std::vector<std::size_t> expected {1, 0, 1, 1};
+  dfa.initialize();
+  for (auto i = 0u; i != input.size(); ++i) {
+    dfa.update(input[i]);
+    log.append_if("rule " + std::to_string(i), dfa.rule() != expected[i]);
+  }
+  // Both \w+ and \d+ match a number, and the earlier rule wins.
+  input = "42";
+  log.append_if("priority", dfa.match(input.begin(), input.end()) != 
+      input.end() || dfa.rule() != 1);
+}
+
+// Matching a string takes the pointer loop, and matching a list takes the
+// generic one. They must agree, also when the cache flushes and when it
+// gives up for the NFA.
+void lazy_dfa_contiguous_test(ttest::error_log& log) {
+  std::vector<std::pair<std::string, std::string>> cases {
+    {"\\w+|\\d+", "abc12 def"},
+    {"a(b|c)*d", "abcbcbdx"},
+    {"a(b|c)*d", "abcbcbx"},
+    {"(a|b)*a(a|b){4}c", "ababbababbbaababbabac"},
+    {"x*", ""}
+  };
+  for (auto& c : cases) {
+    auto& input = c.second;
+    std::list<char> listed(input.begin(), input.end());
+    for (auto limit : {std::size_t{4}, std::size_t{1024}}) {
+      DFA fast(compile_shared(c.first), limit);
+      DFA slow(compile_shared(c.first), limit);
+      std::size_t fast_rule, slow_rule;
+      auto fast_end = fast.match(input.begin(), input.end(), fast_rule);
+      auto slow_end = slow.match(listed.begin(), listed.end(), slow_rule);
+      auto name = c.first + " on " + input;
+      log.append_if(name + " length", 
+          fast_end - input.begin() != std::distance(listed.begin(), slow_end));
+      log.append_if(name + " rule", fast_rule != slow_rule);
+      log.append_if(name + " state", fast.state() != slow.state());
+    }
+  }
+  DFA dfa(compile_shared("(a|b)*a(a|b){8}c"), 16);
+  std::string input;
+  unsigned seed {54321};
+  for (auto i = 0u; i < 2000; ++i) {
+    seed = seed * 1103515245 + 12345;
+    input.push_back((seed >> 16) & 1? 'a' : 'b');
+  }
+  input += "aababababc";
+  log.append_if("nfa switch", match_length(dfa, input) != input.size());
+  log.append_if("not using nfa", !dfa.using_nfa());
+  const char* text {"baabbabbabc"};
+  log.append_if("pointer", dfa.match(text, text + 11) != text + 11);
+}
+
+ttest::test_suite::pointer create_lazy_dfa_test() {
+  using ttest::create_test;
+  return create_test("lazy_dfa", {
+      create_test("states", lazy_dfa_state_test),
+      create_test("cache", lazy_dfa_cache_test),
+      create_test("fallback", lazy_dfa_fallback_test),
+      create_test("rules", lazy_dfa_rule_test),
+      create_test("contiguous", lazy_dfa_contiguous_test)
+  });
+}
@@ -0,0 +1,71 @@
+#include "automaton_test.h"
+#include "automaton/literal_search.h"
+#include "ttest/ttest.h"
+
+#include <algorithm>
+#include <list>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace lex;
+
+void literal_prefix_test(ttest::error_log& log) {
+  std::vector<std::pair<std::string, std::string>> cases {
+    {"ERROR \\w+", "ERROR "}, {"ab|ac", "a"}, {"a*b", ""}, {"(ab)+", "ab"},
+    {"abc", "abc"}, {"ab|cd", ""}, {"a(b|c)d", "a"}, {"x{3}y", "xxxy"}
+  };
+  for (auto& c : cases) {
+    auto prefix = literal_prefix(compile(c.first));
+    log.append_if(c.first + " gave " + prefix, prefix != c.second);
+  }
+  log.append_if("max length", 
+      literal_prefix(compile("abcdef"), 3) != "abc");
+}
+
+// Every block width and every tail length is exercised by searching
+// windows of random text over a small alphabet.
+void find_literal_test(ttest::error_log& log) {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<int> letter('a', 'c');
+  std::string text(300, ' ');
+  for (auto& ch : text) ch = static_cast<char>(letter(gen));
+  std::vector<std::string> literals {"a", "ab", "cab", "abcab", 
+    "aaaaa", "bcabcabcabcabcabcabcabcabcabcabca", "x"};
+  for (auto& literal : literals) {
+    for (std::size_t first = 0; first < 40; ++first) {
+      for (std::size_t last = first; last <= text.size(); last += 7) {
+        auto begin = text.begin() + first;
+        auto end = text.begin() + last;
+        auto expected = std::search(begin, end, literal.begin(), 
+            literal.end());
+        if (find_literal(begin, end, literal) != expected) {
+          log.append(literal + " at " + std::to_string(first) + "-" +
+              std::to_string(last));
+          return;
+        }
+      }
+    }
+  }
+}
+
+void find_literal_forward_test(ttest::error_log& log) {
+  std::string text {"one two three two"};
+  std::list<char> input(text.begin(), text.end());
+  auto found = find_literal(input.begin(), input.end(), std::string{"two"});
+  log.append_if("list", std::distance(input.begin(), found) != 4);
+  log.append_if("empty", 
+      find_literal(text.begin(), text.end(), std::string{}) != text.begin());
+  log.append_if("missing", find_literal(text.begin(), text.end(),
+        std::string{"four"}) != text.end());
+}
+
+ttest::test_suite::pointer create_literal_search_test() {
+  using ttest::create_test;
+  return create_test("literal_search", {
+      create_test("prefix", literal_prefix_test),
+      create_test("find", find_literal_test),
+      create_test("forward", find_literal_forward_test)
+    });
+}
@@ -0,0 +1,113 @@
+#include "automaton_test.h"
+#include "automaton/lazy_dfa.h"
+#include "automaton/literal_trie.h"
+#include "ttest/ttest.h"
+
+#include <algorithm>
+#include <memory>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace lex;
+
+using Traits = std::regex_traits<char>;
+using Program = program<char, Traits>;
+
+void literal_alternatives_test(ttest::error_log& log) {
+  auto words = literal_alternatives(compile("SELECT|FROM|WHERE"));
+  std::vector<std::string> expected {"SELECT", "FROM", "WHERE"};
+  log.append_if("alternation", !words || *words != expected);
+
+  words = literal_alternatives(compile("ab?c"));
+  log.append_if("optional", !words || words->size() != 2);
+
+  for (auto pattern : {"a*", "\\w", "(ab)+", "a{2,}"}) {
+    log.append_if(pattern, literal_alternatives(compile(pattern)));
+  }
+  log.append_if("count", 
+      literal_alternatives(compile("a?a?a?a?a?a?a?a?a?a?a?"), 100));
+}
+
+void literal_trie_priority_test(ttest::error_log& log) {
+  std::vector<std::pair<std::string, std::size_t>> words {
+    {"for", 3}, {"if", 1}, {"iffy", 0}, {"if", 0}, {"", 2}
+  };
+  literal_trie<char> trie(words.begin(), words.end());
+  log.append_if("strings", trie.string_count() != 4);
+  log.append_if("nodes", trie.node_count() != 8);
+
+  literal_trie_engine<char> engine(trie);
+  std::string text {"iff"};
+  log.append_if("if", engine.match(text.begin(), text.end()) 
+      != text.begin() + 2 || engine.rule() != thread_flags::no_rule());
+  engine.initialize();
+  engine.update('i');
+  engine.update('f');
+  log.append_if("rule", engine.state() != match_state::MATCH || 
+      engine.rule() != 0);
+  engine.update('o');
+  log.append_if("dead", engine.state() != match_state::MISMATCH);
+
+  engine.initialize();
+  engine.update('f');
+  engine.update('o');
+  engine.update('r');
+  log.append_if("final", engine.state() != match_state::FINAL_MATCH ||
+      engine.rule() != 3);
+
+  literal_trie<char> empty;
+  literal_trie_engine<char> none(empty);
+  log.append_if("empty", none.state() != match_state::MISMATCH);
+}
+
+// The trie must accept exactly what the lazy_dfa of the joined rules
+// accepts.
+void literal_trie_agreement_test(ttest::error_log& log) {
+  std::vector<std::string> rules {"<=|<", "<<=|<<", "=|==", "<|=", "<=>"};
+  std::vector<std::pair<std::string, std::size_t>> words;
+  for (auto rule = 0u; rule < rules.size(); ++rule) {
+    auto prog = compile(rules[rule]);
+    auto literals = literal_alternatives(prog);
+    if (!literals) {
+      log.append("not literal: " + rules[rule]);
+      return;
+    }
+    for (auto& word : *literals) {
+      words.emplace_back(word, rule);
+    }
+  }
+  literal_trie<char> trie(words.begin(), words.end());
+  literal_trie_engine<char> engine(trie);
+  lazy_dfa<char, Traits> reference(
+      std::make_shared<const Program>(join_rules(rules)));
+
+  std::string alphabet {"<=>"};
+  for (int code = 0; code < 81; ++code) {
+    std::string input;
+    for (int n = code, i = 0; i < 4; ++i, n /= 3) {
+      input.push_back(alphabet[n % 3]);
+    }
+    engine.initialize();
+    reference.initialize();
+    for (auto ch : input) {
+      engine.update(ch);
+      reference.update(ch);
+      if (engine.state() != reference.state() || 
+          engine.rule() != reference.rule()) {
+        log.append(input);
+        return;
+      }
+    }
+  }
+}
+
+ttest::test_suite::pointer create_literal_trie_test() {
+  using ttest::create_test;
+  return create_test("literal_trie", {
+      create_test("alternatives", literal_alternatives_test),
+      create_test("priority", literal_trie_priority_test),
+      create_test("agreement", literal_trie_agreement_test)
+    });
+}
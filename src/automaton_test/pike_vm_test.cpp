@@ -0,0 +1,80 @@
+#include "automaton_test.h"
+#include "automaton/pike_vm.h"
+#include "ttest/ttest.h"
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace lex;
+
+using Traits = std::regex_traits<char>;
+
+// This has the same meaning as matcher_discrepancies in matcher_test.h.
+static int vm_discrepancies(const std::string& pattern, 
+    const std::string& updates, const std::vector<match_state>& states,
+    match_state initial = match_state::UNDECIDED) {
+  pike_vm<char, Traits> vm(compile_shared(pattern));
+  if (vm.state() != initial) return 1;
+  for (auto i = 0u; i != updates.size(); ++i) {
+    vm.update(updates[i]);
+    if (vm.state() != states[i]) return 1;
+  }
+  return 0;
+}
+
+static std::size_t match_length(const std::string& pattern, 
+    const std::string& input) {
+  pike_vm<char, Traits> vm(compile_shared(pattern));
+  return vm.match(input.begin(), input.end()) - input.begin();
+}
+
+void pike_vm_state_test(ttest::error_log& log) {
+  log.append_if("literal", vm_discrepancies("abc", "abcd", {
+        match_state::UNDECIDED, match_state::UNDECIDED,
+        match_state::FINAL_MATCH, match_state::MISMATCH
+      }));
+  log.append_if("alternation", vm_discrepancies("abc|xy", "xyz", {
+        match_state::UNDECIDED, match_state::FINAL_MATCH,
+        match_state::MISMATCH
+      }));
+  log.append_if("bounded", vm_discrepancies("x{1,3}", "xxxx", {
+        match_state::MATCH, match_state::MATCH,
+        match_state::FINAL_MATCH, match_state::MISMATCH
+      }));
+  log.append_if("star", vm_discrepancies("x*", "xxy", {
+        match_state::MATCH, match_state::MATCH,
+        match_state::MISMATCH
+      }, match_state::MATCH));
+  log.append_if("class", vm_discrepancies("\\d+", "12a", {
+        match_state::MATCH, match_state::MATCH,
+        match_state::MISMATCH
+      }));
+}
+
+void pike_vm_match_test(ttest::error_log& log) {
+  log.append_if("longest", match_length("ab|abcd|abc", "abcdef") != 4);
+  log.append_if("no match", match_length("xyz", "xyy") != 0);
+  log.append_if("nested star", match_length("(a*)*b", "aaaab") != 5);
+  log.append_if("nested star mismatch", 
+      match_length("(a*)*b", "aaaaaaaa") != 0);
+  log.append_if("repeat", match_length("(ab){2,}c", "abababc") != 7);
+  log.append_if("optional tail", match_length("a(bc)?", "abd") != 1);
+
+  // The same vm can be reused without reinitializing by hand.
+  pike_vm<char, Traits> vm(compile_shared("\\w+"));
+  std::string input {"lex++"};
+  log.append_if("first", vm.match(input.begin(), input.end()) !=
+      input.begin() + 3);
+  log.append_if("second", vm.match(input.begin(), input.end()) !=
+      input.begin() + 3);
+}
+
+ttest::test_suite::pointer create_pike_vm_test() {
+  using ttest::create_test;
+  return create_test("pike_vm", {
+      create_test("states", pike_vm_state_test),
+      create_test("match", pike_vm_match_test)
+  });
+}
@@ -0,0 +1,115 @@
+#include "automaton_test.h"
+#include "automaton/program.h"
+#include "ttest/ttest.h"
+
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace lex;
+
+using Traits = std::regex_traits<char>;
+using Program = program<char, Traits>;
+
+static bool same_code(const Program& prog, 
+    const std::vector<instruction<char>>& expected) {
+  if (prog.size() != expected.size()) return false;
+  for (auto pc = 0u; pc != prog.size(); ++pc) {
+    const auto& ins = prog[pc];
+    if (ins.op != expected[pc].op || ins.x != expected[pc].x) return false;
+    if (ins.op == opcode::CHAR && ins.ch != expected[pc].ch) return false;
+    if (ins.op == opcode::SPLIT && ins.y != expected[pc].y) return false;
+  }
+  return true;
+}
+
+void program_builder_test(ttest::error_log& log) {
+  program_builder<char, Traits> builder;
+  builder.emit_char('a');
+  auto split = builder.emit_split(builder.position() + 1, 0);
+  builder.emit_predicate([](char ch) {return ch == 'b';});
+  builder.patch_y(split, builder.position());
+  builder.emit_match(3);
+  auto prog = builder.release();
+
+  log.append_if("size", prog.size() != 4);
+  log.append_if("rule count", prog.rule_count() != 4);
+  log.append_if("patch", prog[1].y != 3);
+  log.append_if("char", !prog.accepts(prog[0], 'a') ||
+      prog.accepts(prog[0], 'b'));
+  log.append_if("predicate", !prog.accepts(prog[2], 'b') ||
+      prog.accepts(prog[2], 'a'));
+  log.append_if("consumes", prog[1].consumes() || prog[3].consumes());
+}
+
+void program_lowering_test(ttest::error_log& log) {
+  using I = instruction<char>;
+
+  log.append_if("literal", !same_code(compile("ab", 
+          regex_constants::extended), {
+        I(opcode::CHAR, 'a', 0, 0),
+        I(opcode::CHAR, 'b', 0, 0),
+        I(opcode::MATCH, 0, 0, 0)
+      }));
+
+  log.append_if("alternation", !same_code(compile("a|b", 
+          regex_constants::extended), {
+        I(opcode::SPLIT, 0, 1, 3),
+        I(opcode::CHAR, 'a', 0, 0),
+        I(opcode::JUMP, 0, 4, 0),
+        I(opcode::CHAR, 'b', 0, 0),
+        I(opcode::MATCH, 0, 0, 0)
+      }));
+
+  log.append_if("star", !same_code(compile("x*", 
+          regex_constants::extended), {
+        I(opcode::SPLIT, 0, 1, 3),
+        I(opcode::CHAR, 'x', 0, 0),
+        I(opcode::JUMP, 0, 0, 0),
+        I(opcode::MATCH, 0, 0, 0)
+      }));
+
+  log.append_if("plus", !same_code(compile("x+", 
+          regex_constants::extended), {
+        I(opcode::CHAR, 'x', 0, 0),
+        I(opcode::SPLIT, 0, 0, 2),
+        I(opcode::MATCH, 0, 0, 0)
+      }));
+
+  log.append_if("bounded", !same_code(compile("x{1,3}", 
+          regex_constants::extended), {
+        I(opcode::CHAR, 'x', 0, 0),
+        I(opcode::SPLIT, 0, 2, 5),
+        I(opcode::CHAR, 'x', 0, 0),
+        I(opcode::SPLIT, 0, 4, 5),
+        I(opcode::CHAR, 'x', 0, 0),
+        I(opcode::MATCH, 0, 0, 0)
+      }));
+}
+
+void program_class_test(ttest::error_log& log) {
+  auto prog = compile("if|\\w+|\\d", regex_constants::ECMAScript);
+  // The classes are i, f, digits, the other word characters and
+  // everything else.
+  log.append_if("count", prog.class_count() != 5);
+  log.append_if("letters", prog.byte_class('a') != prog.byte_class('Z') ||
+      prog.byte_class('a') != prog.byte_class('_') ||
+      prog.byte_class('a') == prog.byte_class('7'));
+  log.append_if("keyword", prog.byte_class('i') == prog.byte_class('f') ||
+      prog.byte_class('i') == prog.byte_class('a'));
+  log.append_if("others", prog.byte_class(' ') != prog.byte_class('\xff') ||
+      prog.byte_class(' ') == prog.byte_class('a'));
+  for (auto c = 0u; c != prog.class_count(); ++c) {
+    log.append_if("representative", 
+        prog.byte_class(prog.representative(c)) != c);
+  }
+}
+
+ttest::test_suite::pointer create_program_test() {
+  using ttest::create_test;
+  return create_test("program", {
+      create_test("program_builder", program_builder_test),
+      create_test("lowering", program_lowering_test),
+      create_test("classes", program_class_test)
+  });
+}
@@ -0,0 +1,191 @@
+#include "automaton_test.h"
+#include "automaton/dfa.h"
+#include "automaton/static_dfa.h"
+#include "regex/regex.h"
+#include "ttest/ttest.h"
+
+#include <cstdint>
+#include <limits>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace lex;
+
+namespace {
+struct keyword {
+  static constexpr const char* pattern() {return "if|else";}
+};
+struct number {
+  static constexpr const char* pattern() {return "[0-9]+(\\.[0-9]*)?";}
+};
+struct word {
+  static constexpr const char* pattern() {return "[[:w:]]+";}
+};
+struct repeat {
+  static constexpr const char* pattern() {return "(ab){2,3}c?";}
+};
+struct bracket {
+  static constexpr const char* pattern() {return "[^a-c[:digit:]]+|[]x-]";}
+};
+// A quantifier applies to the last character of a run of literals.
+struct star {
+  static constexpr const char* pattern() {return "ab*";}
+};
+struct plus {
+  static constexpr const char* pattern() {return "if+x";}
+};
+struct posix {
+  static constexpr const char* pattern() {
+    return "[[:alpha:]_][[:alnum:]_]*|[\\]+|[[.q.][=Q=]]-|\\(\\.\\)";
+  }
+};
+
+template <typename... Rules>
+constexpr std::size_t static_match(const char* s, std::size_t& rule) {
+  const auto& table = static_dfa_v<Rules...>;
+  std::size_t accepted {0};
+  rule = std::numeric_limits<std::size_t>::max();
+  auto state = table.start;
+  for (std::size_t i = 0; table.live[state] && s[i]; ++i) {
+    state = table.next[state][table.classes[static_cast<unsigned char>(s[i])]];
+    if (table.rules[state] != std::numeric_limits<std::uint32_t>::max()) {
+      accepted = i + 1;
+      rule = table.rules[state];
+    }
+  }
+  return accepted;
+}
+
+template <typename... Rules>
+constexpr std::size_t static_length(const char* s) {
+  std::size_t rule {0};
+  return static_match<Rules...>(s, rule);
+}
+
+template <typename... Rules>
+constexpr std::size_t static_rule(const char* s) {
+  std::size_t rule {0};
+  static_match<Rules...>(s, rule);
+  return rule;
+}
+}
+
+// These are all checked by the compiler.
+static_assert(static_length<keyword, word>("iffy") == 4, "longest match");
+static_assert(static_rule<keyword, word>("iffy") == 1, "longest rule");
+static_assert(static_rule<keyword, word>("if(") == 0, "rule priority");
+static_assert(static_length<number>("3.25x") == 4, "number");
+static_assert(static_length<repeat>("abababc") == 7, "bounded repeat");
+static_assert(static_length<repeat>("ab") == 0, "too few repeats");
+static_assert(static_length<bracket>("xyz09") == 3, "negated bracket");
+static_assert(static_length<bracket>("]") == 1, "leading ]");
+static_assert(static_length<bracket>("-") == 1, "trailing -");
+static_assert(static_length<posix>("_x1 ") == 3, "classes");
+static_assert(static_length<posix>("\\\\a") == 2, "bracket backslash");
+static_assert(static_length<posix>("Q-") == 2, "collating element");
+static_assert(static_length<posix>("(.)") == 3, "escapes");
+static_assert(static_length<star>("abbb") == 4, "star after a run");
+static_assert(static_length<plus>("ifffx") == 5, "plus after a run");
+
+// Each static table must match exactly what a regex compiled with the
+// same syntax matches.
+template <typename Rule>
+void check_rule(ttest::error_log& log, const std::vector<std::string>& inputs) {
+  regex<char> reg(Rule::pattern(), detail::static_syntax());
+  for (const auto& input : inputs) {
+    auto expected = reg.match(input.begin(), input.end()) - input.begin();
+    log.append_if(std::string(Rule::pattern()) + " on \"" + input + "\"",
+        static_length<Rule>(input.c_str()) != 
+        static_cast<std::size_t>(expected));
+  }
+}
+
+void static_dfa_regex_test(ttest::error_log& log) {
+  std::vector<std::string> inputs {
+    "if", "iffy", "else!", "3.25x", "42", ".5", "word_1 x", "ababab",
+    "ababc", "abc", "xyz09", "]", "-", "x-]", "_x1 ", "\\\\a", "q-", "Q-", "+",
+    "(.)", "(x)", " \t\n", "\x80\xff", "A_9z", "abbb", "abab", "ifffx",
+    "ifx", "ix", "iff"
+  };
+  check_rule<keyword>(log, inputs);
+  check_rule<number>(log, inputs);
+  check_rule<word>(log, inputs);
+  check_rule<repeat>(log, inputs);
+  check_rule<bracket>(log, inputs);
+  check_rule<posix>(log, inputs);
+  check_rule<star>(log, inputs);
+  check_rule<plus>(log, inputs);
+}
+
+// Outside a constant expression a rejected pattern throws, so the checks
+// can be seen at run time. Each of these is rejected or read differently
+// by the runtime syntax.
+void static_dfa_reject_test(ttest::error_log& log) {
+  std::vector<std::string> patterns {
+    "", "\\d+", "\\w", "\\n", "\\]", "^a", "a$", "()", "a**",
+    "[a-\xe9]", "[[:word:]]", "[[.ab.]]", "[[.-.]]", "[[=+=]]",
+    "[[:alpha:]-z]", "a{,2}", "a\\"
+  };
+  for (const auto& pattern : patterns) {
+    bool thrown {false};
+    try {
+      detail::static_program<64> prog {};
+      detail::static_compiler<64>(pattern.c_str(), prog).compile();
+    } catch (const std::invalid_argument&) {
+      thrown = true;
+    }
+    log.append_if("accepted \"" + pattern + "\"", !thrown);
+  }
+}
+
+// The static tables must agree with a dfa built at run time from the same
+// rules.
+void static_dfa_agreement_test(ttest::error_log& log) {
+  std::vector<std::string> rules {
+    keyword::pattern(), number::pattern(), word::pattern(), repeat::pattern()
+  };
+  auto table = build_dfa(join_rules(rules, detail::static_syntax()));
+  if (!table) {
+    log.append("not built");
+    return;
+  }
+  dfa_engine engine(table->view());
+
+  unsigned seed {99};
+  for (auto trial = 0; trial < 200; ++trial) {
+    std::string input;
+    for (auto i = 0; i < 10; ++i) {
+      seed = seed * 1103515245 + 12345;
+      input.push_back("abcefil1.9 "[(seed >> 16) % 11]);
+    }
+    std::size_t rule {0};
+    auto length = static_match<keyword, number, word, repeat>(
+        input.c_str(), rule);
+    std::size_t expected_rule {0};
+    auto expected = engine.match(input.begin(), input.end(), expected_rule);
+    bool matched {expected != input.begin()};
+    if (input.begin() + length != expected ||
+        (matched && rule != expected_rule)) {
+      log.append("\"" + input + "\"");
+    }
+  }
+}
+
+void static_dfa_size_test(ttest::error_log& log) {
+  const auto& table = static_dfa_v<keyword, number, word>;
+  // One byte states suffice for this rule set.
+  log.append_if("state type", sizeof(table.start) != 1);
+  log.append_if("classes", sizeof(table.next[0]) >= 32);
+}
+
+ttest::test_suite::pointer create_static_dfa_test() {
+  using ttest::create_test;
+  return create_test("static_dfa", {
+      create_test("regex", static_dfa_regex_test),
+      create_test("reject", static_dfa_reject_test),
+      create_test("agreement", static_dfa_agreement_test),
+      create_test("size", static_dfa_size_test)
+  });
+}
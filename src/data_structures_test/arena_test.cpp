@@ -0,0 +1,86 @@
+#include "ttest/ttest.h"
+#include "data_structures/arena.h"
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace lex;
+using std::to_string;
+
+void arena_allocate_test(ttest::error_log& log) {
+  arena region(64);
+  auto a = region.allocate(3, 1);
+  auto b = region.allocate(8, 8);
+  log.append_if("alignment", reinterpret_cast<std::uintptr_t>(b) % 8 != 0);
+  log.append_if("overlap", static_cast<char*>(b) < static_cast<char*>(a) + 3);
+  log.append_if("one block", region.block_count() != 1);
+
+  // A request larger than a block gets a block of its own.
+  region.allocate(1000, 16);
+  log.append_if("blocks: " + to_string(region.block_count()),
+      region.block_count() != 2);
+  log.append_if("bytes", region.bytes_allocated() != 1011);
+
+  region.release();
+  log.append_if("released", 
+      region.block_count() != 0 || region.bytes_allocated() != 0);
+}
+
+void arena_scope_test(ttest::error_log& log) {
+  arena outer;
+  arena inner;
+  log.append_if("none", current_arena() != nullptr);
+  {
+    arena_scope a(outer);
+    log.append_if("outer", current_arena() != &outer);
+    {
+      arena_scope b(inner);
+      log.append_if("inner", current_arena() != &inner);
+      arena_scope c(nullptr);
+      log.append_if("off", current_arena() != nullptr);
+    }
+    log.append_if("restored", current_arena() != &outer);
+  }
+  log.append_if("none after", current_arena() != nullptr);
+}
+
+void arena_allocator_test(ttest::error_log& log) {
+  arena region;
+  std::vector<int, arena_allocator<int>> heap_copy;
+  {
+    arena_scope scope(region);
+    std::list<std::string, arena_allocator<std::string>> words;
+    for (int i = 0; i < 100; ++i) {
+      words.push_back(to_string(i));
+    }
+    log.append_if("arena unused", region.bytes_allocated() == 0);
+    log.append_if("list", words.back() != "99");
+
+    std::vector<int, arena_allocator<int>> numbers {1, 2, 3};
+    log.append_if("vector arena", numbers.get_allocator().get_arena() 
+        != &region);
+    arena_scope off(nullptr);
+    // A copy uses the arena current when it is made.
+    heap_copy = std::vector<int, arena_allocator<int>>(numbers);
+  }
+  log.append_if("copy arena", heap_copy.get_allocator().get_arena() 
+      != nullptr);
+  log.append_if("copy", heap_copy.size() != 3 || heap_copy[2] != 3);
+
+  auto pointer = make_arena_unique<std::string>("heap");
+  log.append_if("heap deleter", pointer.get_deleter().region != nullptr);
+  arena_scope scope(region);
+  auto in_arena = make_arena_unique<std::string>("arena");
+  log.append_if("arena deleter", in_arena.get_deleter().region != &region);
+}
+
+ttest::test_suite::pointer create_arena_test() {
+  using ttest::create_test;
+  return create_test("arena", {
+      create_test("allocate", arena_allocate_test),
+      create_test("scope", arena_scope_test),
+      create_test("allocator", arena_allocator_test)
+    });
+}
@@ -3,6 +3,8 @@
 ttest::test_suite::pointer create_simple_buffer_test();
 ttest::test_suite::pointer create_simple_queue_test();
 ttest::test_suite::pointer create_forward_iterator_test();
+ttest::test_suite::pointer create_sparse_set_test();
+ttest::test_suite::pointer create_arena_test();
 
 ttest::test_suite::pointer create_data_structures_module_test() {
   using ttest::create_test;
@@ -10,5 +12,7 @@ ttest::test_suite::pointer create_data_structures_module_test() {
       create_simple_buffer_test(),
       create_simple_queue_test(),
       create_forward_iterator_test(),
+      create_sparse_set_test(),
+      create_arena_test(),
     });
 }
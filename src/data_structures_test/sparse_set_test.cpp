@@ -0,0 +1,43 @@
+#include "ttest/ttest.h"
+#include "data_structures/sparse_set.h"
+
+#include <string>
+#include <vector>
+
+using namespace lex;
+using std::to_string;
+
+void sparse_set_test(ttest::error_log& log) {
+  constexpr unsigned Capacity {10};
+  sparse_set<unsigned> set(Capacity);
+
+  log.append_if("not empty", !set.empty());
+  log.append_if("incorrect capacity: " + to_string(set.capacity()),
+      set.capacity() != Capacity);
+
+  std::vector<unsigned> members {7, 2, 9, 0};
+  for (auto i : members) {
+    log.append_if("unable to insert: " + to_string(i), !set.insert(i));
+  }
+  log.append_if("inserted twice", set.insert(2));
+  log.append_if("incorrect size: " + to_string(set.size()),
+      set.size() != members.size());
+
+  for (auto i = 0u; i < Capacity; ++i) {
+    bool member = i == 7 || i == 2 || i == 9 || i == 0;
+    log.append_if("incorrect membership: " + to_string(i),
+        set.contains(i) != member);
+  }
+
+  log.append_if("incorrect order",
+      std::vector<unsigned>(set.begin(), set.end()) != members);
+
+  set.clear();
+  log.append_if("not cleared", !set.empty() || set.contains(7));
+  log.append_if("unable to reinsert", !set.insert(7));
+}
+
+ttest::test_suite::pointer create_sparse_set_test() {
+  using ttest::create_test;
+  return create_test("sparse_set", sparse_set_test);
+}
@@ -0,0 +1,117 @@
+#include "lex/dfa_lexer.h"
+#include "ttest/ttest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <locale>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace lex;
+
+namespace {
+using string_lexer = dfa_lexer<std::string::const_iterator>;
+
+// This classifies '_' as a letter, and is otherwise the classic table.
+class underscore_ctype : public std::ctype<char> {
+ public:
+  underscore_ctype() : std::ctype<char>(make_table()) {}
+ private:
+  static const mask* make_table() {
+    static mask table[table_size];
+    std::copy(classic_table(), classic_table() + table_size, table);
+    table[static_cast<unsigned char>('_')] |= alpha;
+    return table;
+  }
+};
+
+std::vector<string_lexer::function_type>
+make_actions(std::vector<std::string>& tokens) {
+  using token_type = string_lexer::token_type;
+  return {
+    [&tokens] (token_type t) {tokens.push_back("kw " + t.str());},
+    [&tokens] (token_type t) {tokens.push_back("id " + t.str());},
+    [] (token_type) {}
+  };
+}
+}
+
+// The second lexer finds the dfa in the cache and compiles nothing.
+void dfa_lexer_cache_test(ttest::error_log& log) {
+  std::vector<std::string> rules {"if|else", "[a-z]+", " +"};
+  dfa_cache cache(".");
+  auto key = rule_set_hash(rules.begin(), rules.end(),
+      regex<char>::default_flag);
+  std::remove(cache.path(key).c_str());
+
+  auto first = load_rules(cache, rules.begin(), rules.end());
+  auto second = load_rules(cache, rules.begin(), rules.end());
+  if (!first || !second) {
+    log.append("not loaded");
+    std::remove(cache.path(key).c_str());
+    return;
+  }
+  log.append_if("states",
+      first->view().state_count() != second->view().state_count());
+
+  std::vector<std::string> tokens;
+  std::string input {"if iffy else x?"};
+  string_lexer lx(input.begin(), input.end(), second, make_actions(tokens));
+  while (lx.lex()) {}
+  std::vector<std::string> expected {"kw if", "id iffy", "kw else", "id x"};
+  log.append_if("tokens", tokens != expected);
+  log.append_if("position", lx.position() != 14);
+
+  bool thrown {false};
+  try {
+    string_lexer few(input.begin(), input.end(), second,
+        std::vector<string_lexer::function_type>(2));
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  log.append_if("missing action", !thrown);
+  std::remove(cache.path(key).c_str());
+}
+
+// Saving is best effort. A cache that cannot be written still yields a dfa.
+void dfa_lexer_unsaved_test(ttest::error_log& log) {
+  std::vector<std::string> rules {"if|else", "[a-z]+", " +"};
+  dfa_cache cache("no_such_dfa_directory");
+  auto table = load_rules(cache, rules.begin(), rules.end());
+  if (!table) {
+    log.append("not built");
+    return;
+  }
+  log.append_if("mapped", table->is_mapped());
+
+  std::vector<std::string> tokens;
+  std::string input {"else iffy"};
+  string_lexer lx(input.begin(), input.end(), table, make_actions(tokens));
+  while (lx.lex()) {}
+  std::vector<std::string> expected {"kw else", "id iffy"};
+  log.append_if("tokens", tokens != expected);
+}
+
+// The tables depend on the ctype facet, so the key must too.
+void dfa_lexer_locale_test(ttest::error_log& log) {
+  std::vector<std::string> rules {"[[:alpha:]]+"};
+  auto flags = regex<char>::default_flag;
+  std::locale classic {std::locale::classic()};
+  std::locale underscore(classic, new underscore_ctype);
+  auto key = rule_set_hash(rules.begin(), rules.end(), flags, classic);
+  log.append_if("copy", key != rule_set_hash(rules.begin(), rules.end(),
+        flags, std::locale(classic)));
+  log.append_if("ctype", key == rule_set_hash(rules.begin(), rules.end(),
+        flags, underscore));
+}
+
+ttest::test_suite::pointer create_dfa_lexer_test() {
+  using ttest::create_test;
+  return create_test("dfa_lexer", {
+      create_test("cache", dfa_lexer_cache_test),
+      create_test("unsaved", dfa_lexer_unsaved_test),
+      create_test("locale", dfa_lexer_locale_test)
+  });
+}
@@ -0,0 +1,104 @@
+#include "lex/incremental_lexer.h"
+#include "ttest/ttest.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace lex;
+
+namespace {
+using char_lexer = incremental_lexer<char>;
+
+std::shared_ptr<const char_lexer::translator_type> make_rules() {
+  std::vector<char_lexer::translator_item> items {
+    {"if", nullptr},
+    {"abcd", nullptr},
+    {"(a|b|c|d|i|f)+", nullptr},
+    {" +", nullptr},
+    {"\"(a|b|c| )*\"", nullptr}
+  };
+  return std::make_shared<const char_lexer::translator_type>(
+      items.begin(), items.end());
+}
+
+bool same_tokens(const char_lexer& a, const char_lexer& b) {
+  if (a.tokens().size() != b.tokens().size() || a.lexed() != b.lexed()) {
+    return false;
+  }
+  for (auto i = 0u; i != a.tokens().size(); ++i) {
+    auto& x = a.tokens()[i];
+    auto& y = b.tokens()[i];
+    if (x.rule != y.rule || x.offset != y.offset || x.length != y.length) {
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+// After any edit the tokens must be those of lexing the new text afresh.
+void incremental_lexer_edit_test(ttest::error_log& log) {
+  auto rules = make_rules();
+  char_lexer lx(rules, "if abc \"ab c\" abcd dd");
+  std::string alphabet {"abcdif \"x"};
+  unsigned seed {2024};
+  auto next = [&seed] (unsigned n) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) % n;
+  };
+  for (auto i = 0u; i < 500; ++i) {
+    auto offset = next(lx.text().size() + 1);
+    auto removed = next(4);
+    std::string inserted;
+    for (auto n = next(4); n != 0; --n) {
+      inserted.push_back(alphabet[next(alphabet.size())]);
+    }
+    lx.edit(offset, removed, inserted);
+    char_lexer fresh(rules, lx.text());
+    log.append_if("edit " + std::to_string(i) + ": " + lx.text(),
+        !same_tokens(lx, fresh));
+  }
+}
+
+// An edit in the middle of a long text only lexes a few tokens again.
+void incremental_lexer_local_test(ttest::error_log& log) {
+  std::string text;
+  for (auto i = 0; i < 1000; ++i) {
+    text += "abc if ";
+  }
+  char_lexer lx(make_rules(), text);
+  log.append_if("tokens", lx.tokens().size() != 4000);
+
+  auto change = lx.edit(3500, 0, "d");
+  log.append_if("change", change.first != 1999 || change.removed != 2 ||
+      change.inserted != 2);
+  log.append_if("token", lx.view(lx.tokens()[2000]) != "dabc");
+  log.append_if("moved", lx.tokens().back().offset != 7000);
+  log.append_if("lexed", lx.lexed() != lx.text().size());
+
+  // Opening a string changes everything after it.
+  change = lx.edit(0, 0, "\"");
+  log.append_if("unterminated", lx.lexed() != 0 || !lx.tokens().empty() ||
+      change.removed != 4000);
+  change = lx.edit(0, 1, "");
+  log.append_if("restored", change.inserted != 4000 ||
+      lx.lexed() != lx.text().size());
+
+  bool thrown {false};
+  try {
+    lx.edit(lx.text().size() + 1, 0, "a");
+  } catch (const std::out_of_range&) {
+    thrown = true;
+  }
+  log.append_if("out of range", !thrown);
+}
+
+ttest::test_suite::pointer create_incremental_lexer_test() {
+  using ttest::create_test;
+  return create_test("incremental_lexer", {
+      create_test("edit", incremental_lexer_edit_test),
+      create_test("local", incremental_lexer_local_test)
+  });
+}
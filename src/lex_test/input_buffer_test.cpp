@@ -0,0 +1,127 @@
+#include "iterator_adapter/input_buffer.h"
+#include "ttest/ttest.h"
+
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <unistd.h>
+
+using namespace lex;
+
+// This reads tokens of the given length from the buffer, flushing each
+// one, and returns them joined by '|'.
+template <typename Buffer>
+std::string read_tokens(Buffer& buffer, std::size_t length) {
+  std::string result;
+  while (buffer.begin() != buffer.end()) {
+    auto it = buffer.begin();
+    std::size_t n {0};
+    for (; n < length && it != buffer.end(); ++n, ++it) {}
+    if (!result.empty()) result += '|';
+    result += std::string(buffer.begin(), it);
+    buffer.flush(it);
+  }
+  return result;
+}
+
+void input_buffer_ring_test(ttest::error_log& log) {
+  std::string text {"abcdefghijklmnopq"};
+  input_buffer<std::string::const_iterator> buffer(text.begin(), 
+      text.end(), 3);
+  log.append_if("rounded capacity", buffer.capacity() != 4);
+  auto tokens = read_tokens(buffer, 3);
+  log.append_if("tokens: " + tokens, tokens != "abc|def|ghi|jkl|mno|pq");
+  log.append_if("wrapped but grew", buffer.capacity() != 4);
+  log.append_if("not empty", buffer.size() != 0);
+}
+
+// A token longer than the ring must make it grow.
+void input_buffer_grow_test(ttest::error_log& log) {
+  std::string text {"0123456789"};
+  std::list<char> input(text.begin(), text.end());
+  input_buffer<std::list<char>::const_iterator> buffer(input.begin(), 
+      input.end(), 4);
+  auto first = buffer.begin();
+  log.append_if("empty", first == buffer.end() || *first != '0');
+  buffer.flush(first + 1);
+  auto tokens = read_tokens(buffer, 7);
+  log.append_if("tokens: " + tokens, tokens != "1234567|89");
+  log.append_if("did not grow", buffer.capacity() != 8);
+}
+
+void input_buffer_iterator_test(ttest::error_log& log) {
+  std::string text {"xyz"};
+  input_buffer<const char*> buffer(text.data(), text.data() + text.size());
+  auto it = buffer.begin();
+  log.append_if("end", it == buffer.end());
+  auto last = it + 2;
+  log.append_if("deref", *last != 'z' || it[1] != 'y');
+  log.append_if("distance", std::distance(it, last) != 2 || last - it != 2);
+  log.append_if("order", !(it < last) || last <= it);
+  log.append_if("not end", ++last != buffer.end());
+  log.append_if("sentinels", buffer.end() != buffer.end());
+  // The sentinel has no position, so algorithms must not subtract it.
+  using category = std::iterator_traits<decltype(it)>::iterator_category;
+  log.append_if("category", 
+      !std::is_same<category, std::forward_iterator_tag>::value);
+}
+
+void input_buffer_stream_test(ttest::error_log& log) {
+  std::istringstream stream("one two three");
+  input_buffer<std::istreambuf_iterator<char>> buffer(*stream.rdbuf(), 4);
+  auto tokens = read_tokens(buffer, 4);
+  log.append_if("tokens: " + tokens, tokens != "one |two |thre|e");
+}
+
+void input_buffer_descriptor_test(ttest::error_log& log) {
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    log.append("pipe");
+    return;
+  }
+  std::string text {"read(2) input"};
+  auto written = ::write(fds[1], text.data(), text.size());
+  ::close(fds[1]);
+  log.append_if("write", written != static_cast<long>(text.size()));
+
+  input_buffer<const char*> buffer(file_descriptor {fds[0]});
+  auto tokens = read_tokens(buffer, 100);
+  ::close(fds[0]);
+  log.append_if("tokens: " + tokens, tokens != text);
+}
+
+// A read error must not look like the end of the input.
+void input_buffer_descriptor_error_test(ttest::error_log& log) {
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    log.append("pipe");
+    return;
+  }
+  // The write end of a pipe cannot be read.
+  input_buffer<const char*> buffer(file_descriptor {fds[1]});
+  bool thrown {false};
+  try {
+    log.append_if("input", buffer.begin() != buffer.end());
+  } catch (const std::system_error&) {
+    thrown = true;
+  }
+  ::close(fds[0]);
+  ::close(fds[1]);
+  log.append_if("not thrown", !thrown);
+}
+
+ttest::test_suite::pointer create_input_buffer_test() {
+  using ttest::create_test;
+  return create_test("input_buffer", {
+      create_test("ring", input_buffer_ring_test),
+      create_test("grow", input_buffer_grow_test),
+      create_test("iterator", input_buffer_iterator_test),
+      create_test("stream", input_buffer_stream_test),
+      create_test("descriptor", input_buffer_descriptor_test),
+      create_test("descriptor error", input_buffer_descriptor_error_test)
+    });
+}
@@ -0,0 +1,24 @@
+#include "ttest/ttest.h"
+
+ttest::test_suite::pointer create_static_lexer_test();
+ttest::test_suite::pointer create_token_view_test();
+ttest::test_suite::pointer create_input_buffer_test();
+ttest::test_suite::pointer create_mapped_source_test();
+ttest::test_suite::pointer create_lexer_test();
+ttest::test_suite::pointer create_push_lexer_test();
+ttest::test_suite::pointer create_incremental_lexer_test();
+ttest::test_suite::pointer create_dfa_lexer_test();
+
+ttest::test_suite::pointer create_lex_module_test() {
+  using ttest::create_test;
+  return create_test("lex", {
+      create_static_lexer_test(),
+      create_token_view_test(),
+      create_input_buffer_test(),
+      create_mapped_source_test(),
+      create_lexer_test(),
+      create_push_lexer_test(),
+      create_incremental_lexer_test(),
+      create_dfa_lexer_test(),
+    });
+}
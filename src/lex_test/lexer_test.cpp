@@ -0,0 +1,195 @@
+#include "lex/lexer.h"
+#include "ttest/ttest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace lex;
+
+namespace {
+using string_lexer = lexer<std::string::const_iterator>;
+using stream_lexer = lexer<std::istreambuf_iterator<char>>;
+using pointer_lexer = lexer<const char*>;
+
+template <typename Lexer>
+std::shared_ptr<const typename Lexer::translator_type> 
+make_rules(std::vector<std::string>& tokens) {
+  using token_type = typename Lexer::token_type;
+  std::vector<typename Lexer::translator_item> items {
+    {"if|else", [&tokens] (token_type t) {tokens.push_back("kw " + t.str());}},
+    {"x+", [&tokens] (const std::string& s) {tokens.push_back("x " + s);}},
+    {" +", [] (token_type) {}}
+  };
+  return std::make_shared<const typename Lexer::translator_type>(
+      items.begin(), items.end());
+}
+
+template <typename Lexer>
+std::shared_ptr<const typename Lexer::translator_type> 
+make_silent_rules(const std::vector<std::string>& rules) {
+  std::vector<typename Lexer::translator_item> items;
+  for (auto& r : rules) {
+    items.push_back({r, [] (typename Lexer::token_type) {}});
+  }
+  return std::make_shared<const typename Lexer::translator_type>(
+      items.begin(), items.end());
+}
+}
+
+void lexer_lex_test(ttest::error_log& log) {
+  std::vector<std::string> tokens;
+  std::string input {"if xx else  x?"};
+  string_lexer lx(input.begin(), input.end(), make_rules<string_lexer>(tokens));
+  while (lx.lex()) {}
+  std::vector<std::string> expected {"kw if", "x xx", "kw else", "x x"};
+  log.append_if("tokens", tokens != expected);
+  log.append_if("position", lx.position() != 13);
+}
+
+void lexer_stream_test(ttest::error_log& log) {
+  std::vector<std::string> tokens;
+  std::istringstream stream("xxx if");
+  stream_lexer lx(*stream.rdbuf(), make_rules<stream_lexer>(tokens));
+  while (lx.lex()) {}
+  std::vector<std::string> expected {"x xxx", "kw if"};
+  log.append_if("tokens", tokens != expected);
+}
+
+// Tokens of a mapped file point straight into the mapping.
+void lexer_file_test(ttest::error_log& log) {
+  const std::string path {"lexer_file_test.txt"};
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << "else xxx if";
+
+  std::vector<std::string> tokens;
+  auto rules = make_rules<pointer_lexer>(tokens);
+  auto lx = pointer_lexer::from_file(path, rules);
+  std::remove(path.c_str());
+  while (lx.lex()) {}
+  std::vector<std::string> expected {"kw else", "x xxx", "kw if"};
+  log.append_if("tokens", tokens != expected);
+
+  std::string text {"if"};
+  const char* seen {nullptr};
+  std::vector<pointer_lexer::translator_item> items {
+    {"if", [&seen] (pointer_lexer::token_type t) {seen = t.data();}}
+  };
+  pointer_lexer in_place(text.data(), text.data() + text.size(), 
+      std::make_shared<const pointer_lexer::translator_type>(
+        items.begin(), items.end()));
+  in_place.lex();
+  log.append_if("not in place", seen != text.data());
+
+  bool thrown {false};
+  try {
+    pointer_lexer::from_file("no/such/file", rules);
+  } catch (const std::system_error&) {
+    thrown = true;
+  }
+  log.append_if("missing file", !thrown);
+}
+
+void lexer_batch_test(ttest::error_log& log) {
+  std::vector<std::string> tokens;
+  std::string input {"if xx else"};
+  string_lexer lx(input.begin(), input.end(), make_rules<string_lexer>(tokens));
+
+  token_record records[2];
+  log.append_if("batch count", lx.lex_batch(records, 2) != 2);
+  log.append_if("record 0", records[0].rule != 0 || records[0].offset != 0 ||
+      records[0].length != 2);
+  log.append_if("record 1", records[1].rule != 2 || records[1].offset != 2 ||
+      records[1].length != 1);
+
+  token_columns columns;
+  log.append_if("columns count", lx.lex_into(columns, 10) != 3);
+  log.append_if("base", columns.base != 3);
+  std::vector<std::uint32_t> rules {1, 2, 0};
+  std::vector<std::uint32_t> offsets {0, 2, 3};
+  std::vector<std::uint32_t> lengths {2, 1, 4};
+  log.append_if("columns", columns.rule != rules || 
+      columns.offset != offsets || columns.length != lengths);
+  log.append_if("no actions", !tokens.empty());
+
+  // A count is only a bound; nothing that large is reserved.
+  std::string more {"if xx"};
+  string_lexer unbounded(more.begin(), more.end(), 
+      make_rules<string_lexer>(tokens));
+  auto count = std::numeric_limits<std::size_t>::max();
+  log.append_if("unbounded count", unbounded.lex_into(columns, count) != 3 ||
+      columns.rule.capacity() > 4096);
+}
+
+// A string is lexed by matching each engine on its own over pointers, and a
+// list by running the engines in lockstep. The tokens must be the same.
+void lexer_contiguous_test(ttest::error_log& log) {
+  using list_lexer = lexer<std::list<char>::const_iterator>;
+  std::vector<std::string> rules {"if", "(i|f|y|x)+", "(1|2|7)+|if1", " +"};
+  std::string input {"if iffy if1 if12 x 7 i"};
+  std::list<char> listed(input.begin(), input.end());
+
+  std::vector<token_record> fast(16), slow(16);
+  string_lexer fast_lexer(input.begin(), input.end(), 
+      make_silent_rules<string_lexer>(rules));
+  list_lexer slow_lexer(listed.begin(), listed.end(),
+      make_silent_rules<list_lexer>(rules));
+  auto fast_count = fast_lexer.lex_batch(fast.data(), fast.size());
+  auto slow_count = slow_lexer.lex_batch(slow.data(), slow.size());
+  log.append_if("count", fast_count != 14 || slow_count != fast_count);
+  for (auto i = 0u; i < fast_count && i < slow_count; ++i) {
+    log.append_if("token " + std::to_string(i), 
+        fast[i].rule != slow[i].rule || fast[i].offset != slow[i].offset ||
+        fast[i].length != slow[i].length);
+  }
+  // "if1" is a keyword of rule 2, and beats "if" by length.
+  log.append_if("keyword", fast[4].rule != 2 || fast[4].length != 3);
+}
+
+// An icase rule of keywords is run by the trie, like any other keywords,
+// and both cases of each letter follow the same edges.
+void lexer_icase_keyword_test(ttest::error_log& log) {
+  using translator_type = string_lexer::translator_type;
+  using regex_type = translator_type::regex_type;
+  auto ignore = [] (string_lexer::token_type) {};
+  std::vector<translator_type::value_type> items {
+    {regex_type(std::string("select|from"), regex_constants::icase), ignore},
+    {regex_type(std::string("SELECT_ALL")), ignore},
+    {regex_type(std::string("[a-z_]+")), ignore},
+    {regex_type(std::string(" +")), ignore}
+  };
+  auto rules = std::make_shared<const translator_type>(items);
+  log.append_if("keywords", rules->get_keywords()->string_count() != 3);
+  const auto& patterns = *rules->get_patterns();
+  log.append_if("patterns", std::count_if(patterns.begin(), patterns.end(),
+        [] (const auto& ins) {return ins.op == opcode::MATCH;}) != 2);
+
+  std::string input {"SeLeCt FROM select_all SELECT_ALL fRoM"};
+  string_lexer lx(input.begin(), input.end(), rules);
+  std::vector<token_record> records(16);
+  auto count = lx.lex_batch(records.data(), records.size());
+  std::vector<std::uint32_t> expected {0, 3, 0, 3, 2, 3, 1, 3, 0};
+  std::vector<std::uint32_t> lexed;
+  for (auto i = 0u; i < count; ++i) {
+    lexed.push_back(records[i].rule);
+  }
+  log.append_if("rules", lexed != expected);
+}
+
+ttest::test_suite::pointer create_lexer_test() {
+  using ttest::create_test;
+  return create_test("lexer", {
+      create_test("lex", lexer_lex_test),
+      create_test("stream", lexer_stream_test),
+      create_test("file", lexer_file_test),
+      create_test("batch", lexer_batch_test),
+      create_test("contiguous", lexer_contiguous_test),
+      create_test("icase keywords", lexer_icase_keyword_test)
+    });
+}
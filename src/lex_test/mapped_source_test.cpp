@@ -0,0 +1,37 @@
+#include "iterator_adapter/mapped_source.h"
+#include "ttest/ttest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace lex;
+
+void mapped_source_test(ttest::error_log& log) {
+  const std::string path {"mapped_source_test.txt"};
+  std::string text {"mapped\ninput"};
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+
+  mapped_source source(path);
+  log.append_if("not open", !source.is_open());
+  log.append_if("contents", 
+      std::string(source.begin(), source.end()) != text);
+
+  auto moved = std::move(source);
+  log.append_if("moved", source.is_open() || moved.size() != text.size());
+
+  std::ofstream(path, std::ios::binary | std::ios::trunc);
+  log.append_if("empty", !moved.open(path) || moved.size() != 0 || 
+      moved.begin() != moved.end());
+  std::remove(path.c_str());
+
+  log.append_if("missing", moved.open(path) || moved.is_open() ||
+      moved.error() == 0);
+}
+
+ttest::test_suite::pointer create_mapped_source_test() {
+  using ttest::create_test;
+  return create_test("mapped_source", {
+      create_test("map", mapped_source_test)
+    });
+}
@@ -0,0 +1,171 @@
+#include "lex/push_lexer.h"
+#include "ttest/ttest.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace lex;
+
+namespace {
+using char_lexer = push_lexer<char>;
+
+std::shared_ptr<const char_lexer::translator_type>
+make_rules(std::vector<std::string>& tokens) {
+  using token_type = char_lexer::token_type;
+  std::vector<char_lexer::translator_item> items {
+    {"ab", [&tokens] (token_type t) {tokens.push_back("ab " + t.str());}},
+    {"abcd", [&tokens] (token_type t) {tokens.push_back("abcd " + t.str());}},
+    {"c", [&tokens] (const std::string& s) {tokens.push_back("c " + s);}},
+    {"x+", [&tokens] (token_type t) {tokens.push_back("x " + t.str());}},
+    {" +", [] (token_type) {}}
+  };
+  return std::make_shared<const char_lexer::translator_type>(
+      items.begin(), items.end());
+}
+}
+
+// The tokens must not depend on where the input is split into chunks.
+void push_lexer_chunk_test(ttest::error_log& log) {
+  std::string input {"abcab xxx abcd cxx abc"};
+  std::vector<std::string> expected {
+    "ab ab", "c c", "ab ab", "x xxx", "abcd abcd", "c c", "x xx",
+    "ab ab", "c c"
+  };
+  for (auto size = 1u; size <= input.size(); ++size) {
+    std::vector<std::string> tokens;
+    char_lexer lx(make_rules(tokens));
+    for (auto i = 0u; i < input.size(); i += size) {
+      lx.feed(input.substr(i, size));
+    }
+    lx.finish();
+    auto name = "chunk size " + std::to_string(size);
+    log.append_if(name, tokens != expected);
+    log.append_if(name + " position", lx.position() != input.size());
+    log.append_if(name + " pending", !lx.pending().empty());
+  }
+
+  // Nor may what is left after a token that matches no rule.
+  input = "xacxx";
+  for (auto size = 1u; size <= input.size(); ++size) {
+    std::vector<std::string> tokens;
+    char_lexer lx(make_rules(tokens));
+    for (auto i = 0u; i < input.size(); i += size) {
+      lx.feed(input.substr(i, size));
+    }
+    lx.finish();
+    auto name = "failed chunk size " + std::to_string(size);
+    log.append_if(name, tokens != std::vector<std::string> {"x x"});
+    log.append_if(name + " failed", !lx.failed());
+    log.append_if(name + " pending", lx.pending() != "acxx");
+  }
+}
+
+// A token is emitted as soon as no rule can extend it, and only the
+// undecided token is carried over.
+void push_lexer_early_test(ttest::error_log& log) {
+  std::vector<std::string> tokens;
+  char_lexer lx(make_rules(tokens));
+  log.append_if("decided", lx.feed("abcd xx") != 2);
+  log.append_if("carry", lx.pending() != "xx");
+  log.append_if("undecided", tokens.size() != 1);
+  log.append_if("continued", lx.feed("x ") != 1 || tokens.back() != "x xxx");
+  log.append_if("finish", lx.finish() != 1 || lx.position() != 9);
+}
+
+void push_lexer_failure_test(ttest::error_log& log) {
+  std::vector<std::string> tokens;
+  char_lexer lx(make_rules(tokens));
+  log.append_if("emitted", lx.feed("ab q") != 2);
+  log.append_if("failed", !lx.failed());
+  log.append_if("pending", lx.pending() != "q");
+  log.append_if("ignored", lx.feed("ab") != 0 || lx.finish() != 0);
+
+  // The rest of an unfinished token matches no rule at the end.
+  char_lexer partial(make_rules(tokens));
+  partial.feed("ab ab a");
+  log.append_if("not failed early", partial.failed());
+  partial.finish();
+  log.append_if("not failed", !partial.failed());
+  log.append_if("partial pending", partial.pending() != "a");
+  log.append_if("partial position", partial.position() != 6);
+}
+
+// Once the token crossing into a chunk is done, the rest of the chunk is
+// lexed in place.
+void push_lexer_in_place_test(ttest::error_log& log) {
+  using token_type = char_lexer::token_type;
+  std::vector<std::string> strings;
+  std::vector<const char*> begins;
+  auto record = [&strings, &begins] (token_type t) {
+    strings.push_back(t.str());
+    begins.push_back(t.begin());
+  };
+  std::vector<char_lexer::translator_item> items {
+    {"[a-z]+", record},
+    {" +", record}
+  };
+  char_lexer lx(char_lexer::translator_type(items.begin(), items.end()));
+  lx.feed("ab");
+  std::string chunk {"cd ef gh ij "};
+  log.append_if("emitted", lx.feed(chunk) != 7 || strings.size() != 7);
+  log.append_if("carried", strings.front() != "abcd");
+  for (auto i = 1u; i < begins.size(); ++i) {
+    log.append_if("copied " + std::to_string(i), begins[i] < chunk.data() || 
+        chunk.data() + chunk.size() <= begins[i]);
+  }
+  log.append_if("pending", lx.pending() != " ");
+}
+
+// A lexer restored from a snapshot goes on as if it had never stopped.
+void push_lexer_snapshot_test(ttest::error_log& log) {
+  std::string input {"xx abcab abc xxx"};
+  std::vector<std::string> expected;
+  char_lexer whole(make_rules(expected));
+  whole.feed(input);
+  whole.finish();
+
+  for (auto split = 0u; split <= input.size(); ++split) {
+    std::vector<std::string> tokens;
+    std::string saved;
+    {
+      char_lexer first(make_rules(tokens));
+      first.feed(input.substr(0, split));
+      saved = first.snapshot(42);
+    }
+    char_lexer second(make_rules(tokens));
+    auto name = "split " + std::to_string(split);
+    log.append_if(name + " restore", !second.restore(saved, 42));
+    second.feed(input.substr(split));
+    second.finish();
+    log.append_if(name, tokens != expected);
+    log.append_if(name + " position", second.position() != input.size());
+  }
+
+  std::vector<std::string> tokens;
+  char_lexer lx(make_rules(tokens));
+  lx.feed("ab xx");
+  auto saved = lx.snapshot(7);
+  char_lexer other(make_rules(tokens));
+  log.append_if("wrong key", other.restore(saved, 8));
+  log.append_if("truncated", other.restore(saved.substr(0, 
+          saved.size() - 1), 7));
+  log.append_if("unchanged", other.position() != 0);
+
+  lx.feed("?");
+  char_lexer failed(make_rules(tokens));
+  log.append_if("failed restore", !failed.restore(lx.snapshot()));
+  log.append_if("failed state", !failed.failed() || 
+      failed.pending() != "?" || failed.position() != 5);
+}
+
+ttest::test_suite::pointer create_push_lexer_test() {
+  using ttest::create_test;
+  return create_test("push_lexer", {
+      create_test("chunks", push_lexer_chunk_test),
+      create_test("early", push_lexer_early_test),
+      create_test("failure", push_lexer_failure_test),
+      create_test("in place", push_lexer_in_place_test),
+      create_test("snapshot", push_lexer_snapshot_test)
+  });
+}
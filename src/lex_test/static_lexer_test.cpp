@@ -0,0 +1,74 @@
+#include "lex/static_lexer.h"
+#include "ttest/ttest.h"
+
+#include <string>
+#include <vector>
+
+using namespace lex;
+
+namespace {
+std::vector<std::string> tokens;
+
+struct keyword {
+  static constexpr const char* pattern() {return "if|else|while";}
+  template <typename It>
+  static void action(It begin, It end) {
+    tokens.push_back("keyword " + std::string(begin, end));
+  }
+};
+struct identifier {
+  static constexpr const char* pattern() {return "[a-zA-Z_][[:w:]]*";}
+  template <typename It>
+  static void action(It begin, It end) {
+    tokens.push_back("identifier " + std::string(begin, end));
+  }
+};
+struct number {
+  static constexpr const char* pattern() {return "[[:digit:]]+";}
+  template <typename It>
+  static void action(It begin, It end) {
+    tokens.push_back("number " + std::string(begin, end));
+  }
+};
+struct space {
+  static constexpr const char* pattern() {return "[[:space:]]+";}
+  template <typename It>
+  static void action(It, It) {}
+};
+
+using test_lexer = static_lexer<keyword, identifier, number, space>;
+
+constexpr std::size_t rule_of(const char* s, std::size_t n) {
+  std::size_t rule {0};
+  test_lexer::match(s, s + n, rule);
+  return rule;
+}
+}
+
+static_assert(rule_of("while", 5) == 0, "keyword");
+static_assert(rule_of("whiled", 6) == 1, "identifier");
+static_assert(rule_of("?", 1) == test_lexer::no_rule(), "no match");
+
+void static_lexer_lex_test(ttest::error_log& log) {
+  tokens.clear();
+  std::string input {"if x1 else 42 iffy!"};
+  auto it = input.begin();
+  while (it != input.end()) {
+    auto next = test_lexer::lex(it, input.end());
+    if (next == it) break;
+    it = next;
+  }
+  std::vector<std::string> expected {
+    "keyword if", "identifier x1", "keyword else", "number 42", 
+    "identifier iffy"
+  };
+  log.append_if("tokens", tokens != expected);
+  log.append_if("stopped", it != input.end() - 1);
+}
+
+ttest::test_suite::pointer create_static_lexer_test() {
+  using ttest::create_test;
+  return create_test("static_lexer", {
+      create_test("lex", static_lexer_lex_test)
+  });
+}
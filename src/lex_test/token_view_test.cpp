@@ -0,0 +1,56 @@
+#include "lex/token_view.h"
+#include "ttest/ttest.h"
+
+#include <functional>
+#include <list>
+#include <sstream>
+#include <string>
+
+using namespace lex;
+
+void token_view_test(ttest::error_log& log) {
+  std::string text {"while (x)"};
+  token_view<std::string::const_iterator> token(text.begin(), 
+      text.begin() + 5);
+  log.append_if("size", token.size() != 5);
+  log.append_if("string", token != std::string("while"));
+  log.append_if("c string", token != "while" || token == "whil" || 
+      token == "whiles");
+  log.append_if("data", token.data() != text.data());
+  log.append_if("str", token.str() != "while");
+
+  std::ostringstream out;
+  out << token;
+  log.append_if("stream", out.str() != "while");
+
+  token_view<std::string::const_iterator> empty;
+  log.append_if("empty", !empty.empty() || empty.size() != 0);
+}
+
+// A view over a buffer that is not contiguous, passed to actions of both
+// kinds.
+void token_view_action_test(ttest::error_log& log) {
+  std::list<char> buffer {'i', 'f', ' '};
+  using view_type = token_view<std::list<char>::const_iterator>;
+  view_type token(buffer.begin(), std::prev(buffer.end()));
+
+  std::string seen;
+  std::function<void(view_type)> by_view = [&seen] (view_type t) {
+    seen = t;
+  };
+  std::function<void(view_type)> by_string = 
+    [&seen] (const std::string& s) {
+      seen += s;
+    };
+  by_view(token);
+  by_string(token);
+  log.append_if("actions", seen != "ifif");
+}
+
+ttest::test_suite::pointer create_token_view_test() {
+  using ttest::create_test;
+  return create_test("token_view", {
+      create_test("view", token_view_test),
+      create_test("actions", token_view_action_test)
+    });
+}
@@ -1,7 +1,9 @@
 #include "matcher_test.h"
+#include "matcher/alternation.h"
 #include "matcher/atomic.h"
 #include "matcher/string_literal.h"
 #include "matcher/concatenation.h"
+#include "matcher/replication.h"
 #include "ttest/ttest.h"
 
 #include <string>
@@ -32,7 +34,63 @@ void concatenation_test(ttest::error_log& log) {
   matcher.initialize();
 }
 
+// Without merging, (a*)*b starts a new progression on every character, so
+// a long input would take quadratic time.
+void nested_concatenation_test(ttest::error_log& log) {
+  using namespace lex;
+  const std::size_t unbounded = -1;
+
+  auto inner = replicate(singleton_matcher('a', traits),
+      replication_data(0, unbounded));
+  auto outer = replicate(std::move(inner), replication_data(0, unbounded));
+  std::vector<decltype(outer)> list {outer, singleton_matcher('b', traits)};
+  auto matcher = concatenate(std::move(list));
+
+  std::string input(20000, 'a');
+  bool undecided {true};
+  for (auto ch : input) {
+    matcher.update(ch);
+    undecided = undecided && matcher.state() == match_state::UNDECIDED;
+  }
+  log.append_if("(a*)*b undecided", !undecided);
+  matcher.update('b');
+  log.append_if("(a*)*b final", matcher.state() != match_state::FINAL_MATCH);
+
+  auto copy = matcher;
+  copy.initialize();
+  if (matcher_discrepancies(copy, "aabc"s, {
+        match_state::UNDECIDED, match_state::UNDECIDED, 
+        match_state::FINAL_MATCH, match_state::MISMATCH 
+      })) {
+    log.append("aabc");
+  }
+
+  // The same holds when the repeated operand is an alternation.
+  std::vector<decltype(outer)> branches {
+    singleton_matcher('a', traits), string_matcher("bc"s, traits)
+  };
+  auto repeated = replicate(alternation(std::move(branches)), 
+      replication_data(0, unbounded));
+  std::vector<decltype(outer)> tail {repeated, singleton_matcher('d', traits)};
+  auto alternating = concatenate(std::move(tail));
+  std::string text;
+  for (auto i = 0; i < 10000; ++i) {
+    text += "abc";
+  }
+  for (auto ch : text) {
+    alternating.update(ch);
+  }
+  log.append_if("(a|bc)*d undecided", 
+      alternating.state() != match_state::UNDECIDED);
+  alternating.update('d');
+  log.append_if("(a|bc)*d final", 
+      alternating.state() != match_state::FINAL_MATCH);
+}
+
 ttest::test_suite::pointer create_concatenation_test() {
   using ttest::create_test;
-  return create_test("concatenation", concatenation_test);
+  return create_test("concatenation", {
+      create_test("strings", concatenation_test),
+      create_test("nested", nested_concatenation_test)
+  });
 }
@@ -0,0 +1,99 @@
+#include "matcher/ctype_table.h"
+#include "ttest/ttest.h"
+
+#include <cstddef>
+#include <locale>
+#include <memory>
+#include <regex>
+#include <string>
+
+using namespace lex;
+
+namespace {
+// These traits count '#' as a character of every class.
+struct hash_traits : std::regex_traits<char> {
+  bool isctype(char ch, char_class_type c) const {
+    return ch == '#' || std::regex_traits<char>::isctype(ch, c);
+  }
+};
+}
+
+// The table must agree with the traits it was built from.
+void ctype_table_traits_test(ttest::error_log& log) {
+  std::regex_traits<char> traits;
+  for (std::string name : {"alnum", "digit", "space", "punct", "w"}) {
+    auto table = ctype_table<char>::get(traits, name, false);
+    if (!table) {
+      log.append("no table: " + name);
+      continue;
+    }
+    auto cls = traits.lookup_classname(name.begin(), name.end());
+    for (std::size_t code = 0; code != 256; ++code) {
+      auto ch = static_cast<char>(code);
+      log.append_if(name + " " + std::to_string(code),
+          table->is(ch) != traits.isctype(ch, cls));
+    }
+  }
+
+  std::regex_traits<wchar_t> wide_traits;
+  std::wstring alpha(L"alpha");
+  auto wide = ctype_table<wchar_t>::get(wide_traits, alpha, false);
+  auto cls = wide_traits.lookup_classname(alpha.begin(), alpha.end());
+  for (auto ch : std::wstring(L"a0 _\xe9\x3b1\x2003")) {
+    log.append_if("wchar_t", !wide || wide->is(ch) !=
+        wide_traits.isctype(ch, cls));
+  }
+
+  hash_traits custom;
+  auto digit = ctype_table<char>::get(custom, std::string("d"), false);
+  log.append_if("custom traits", !digit || !digit->is('#') ||
+      !digit->is('7') || digit->is('x'));
+  log.append_if("unknown", ctype_table<char>::get(traits,
+        std::string("nothing"), false));
+}
+
+// Tables are shared while they are in use, and the cache does not keep
+// them.
+void ctype_table_cache_test(ttest::error_log& log) {
+  std::regex_traits<char> traits;
+  auto copy = traits;
+  std::string name {"alpha"};
+  auto table = ctype_table<char>::get(traits, name, false);
+  log.append_if("not shared", table != ctype_table<char>::get(copy, name,
+        false));
+  log.append_if("icase", table == ctype_table<char>::get(traits, name,
+        true));
+
+  std::weak_ptr<const ctype_table<char>> released =
+    ctype_table<char>::get(traits, std::string("xdigit"), false);
+  log.append_if("kept", !released.expired());
+}
+
+void ctype_class_test(ttest::error_log& log) {
+  auto word = lookup_ctype_class(std::string("w"), false);
+  log.append_if("w", !word || !word->word ||
+      word->mask != std::ctype_base::alnum);
+
+  auto lower = lookup_ctype_class(std::string("lower"), false);
+  log.append_if("lower", !lower || lower->mask != std::ctype_base::lower);
+  lower = lookup_ctype_class(std::string("lower"), true);
+  log.append_if("icase lower", !lower ||
+      lower->mask != std::ctype_base::alpha);
+
+  std::regex_traits<char> traits;
+  auto table = ctype_table<char>::get(traits, std::string("lower"), true);
+  log.append_if("icase table", !table || !table->is('A'));
+
+  log.append_if("unknown", lookup_ctype_class(std::string("nothing"), false));
+  log.append_if("wide name", !lookup_ctype_class(std::wstring(L"xdigit"),
+        false));
+}
+
+ttest::test_suite::pointer create_ctype_table_test() {
+  using ttest::create_test;
+  return create_test("ctype_table", {
+      create_test("traits", ctype_table_traits_test),
+      create_test("cache", ctype_table_cache_test),
+      create_test("class", ctype_class_test)
+  });
+}
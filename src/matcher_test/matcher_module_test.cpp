@@ -4,6 +4,7 @@
 ttest::test_suite::pointer create_matcher_test();
 ttest::test_suite::pointer create_matcher_impl_test();
 ttest::test_suite::pointer create_atomic_test();
+ttest::test_suite::pointer create_ctype_table_test();
 ttest::test_suite::pointer create_string_literal_test();
 ttest::test_suite::pointer create_replication_test();
 ttest::test_suite::pointer create_concatenation_test();
@@ -18,6 +19,7 @@ ttest::test_suite::pointer create_matcher_module_test() {
       create_matcher_test(),
       create_matcher_impl_test(),
       create_atomic_test(),
+      create_ctype_table_test(),
       create_string_literal_test(),
       create_replication_test(),
       create_concatenation_test(),
@@ -3,7 +3,11 @@
 
 #include "project_assert.h"
 #include <cctype>
+#include <cwchar>
 #include <functional>
+#include <locale>
+#include <string>
+#include <vector>
 
 using namespace lex;
 
@@ -26,7 +30,7 @@ void matching_bracket_list_test(ttest::error_log& log) {
   PredT c = [](auto ch) {return ch == ';';};
   PredT d = [](auto ch) {return ch == '.';};
 
-  bracket_list<PredT> list;
+  bracket_list<char> list;
   list.add_element(a);
   list.add_element(b);
   list.add_element(std::move(c));
@@ -46,7 +50,7 @@ void non_matching_bracket_list_test(ttest::error_log& log) {
   PredT c = [](auto ch) {return ch == ';';};
   PredT d = [](auto ch) {return ch == '.';};
 
-  bracket_list<PredT> list;
+  bracket_list<char> list;
   list.set_matching(false);
   list.add_element(a);
   list.add_element(b);
@@ -60,3 +64,88 @@ void non_matching_bracket_list_test(ttest::error_log& log) {
     log.append("fail");
   }
 }
+
+// Ranges are merged and negated in the compiled bitmap or table.
+void range_bracket_list_test(ttest::error_log& log) {
+  bracket_list<char> list;
+  list.add_range('a', 'f');
+  list.add_range('d', 'k');
+  list.add_char('l');
+  list.add_char('0');
+  list.add_range('\x80', '\xff');
+  auto combination = list.combine();
+  if (!verify(combination, "adkl0m1\x80\xff", {true, true, true, true, true,
+        false, false, true, true})) {
+    log.append("byte matching");
+  }
+
+  list.set_matching(false);
+  combination = list.combine();
+  if (!verify(combination, "adkl0m1\x80", {false, false, false, false,
+        false, true, true, false})) {
+    log.append("byte non-matching");
+  }
+
+  bracket_list<wchar_t> wide;
+  wide.add_range(L'a', L'f');
+  wide.add_range(L'g', L'k');
+  wide.add_char(L'\x3b1');
+  wide.add_char(L'_');
+  wide.add_range(L'0', L'9');
+  auto wide_combination = wide.combine();
+  std::wstring inputs {L"_a5kz\x3b1\x3b2 "};
+  std::vector<bool> outputs {true, true, true, true, false, true, false, 
+    false};
+  for (auto i = 0u; i != inputs.size(); ++i) {
+    log.append_if("wide matching", wide_combination(inputs[i]) != outputs[i]);
+  }
+
+  wide.set_matching(false);
+  wide_combination = wide.combine();
+  for (auto i = 0u; i != inputs.size(); ++i) {
+    log.append_if("wide non-matching", 
+        wide_combination(inputs[i]) == outputs[i]);
+  }
+  log.append_if("wide limits", !wide_combination(WCHAR_MAX) || 
+      !wide_combination(WCHAR_MIN));
+
+  wide.add_element([](wchar_t ch) {return ch == L'z';});
+  wide_combination = wide.combine();
+  log.append_if("wide element", wide_combination(L'z') || 
+      wide_combination(L'a') || !wide_combination(L'y'));
+}
+
+void icase_bracket_list_test(ttest::error_log& log) {
+  std::locale loc;
+  bracket_list<char> list;
+  list.set_icase(std::use_facet<std::ctype<char>>(loc));
+  list.add_range('a', 'c');
+  list.add_char('X');
+  list.add_char('_');
+  if (!verify(list.combine(), "aBCxX_dD", {true, true, true, true, true,
+        true, false, false})) {
+    log.append("byte matching");
+  }
+  list.set_matching(false);
+  if (!verify(list.combine(), "AbxD", {false, false, false, true})) {
+    log.append("byte non-matching");
+  }
+
+  bracket_list<wchar_t> wide;
+  wide.set_icase(std::use_facet<std::ctype<wchar_t>>(loc));
+  wide.add_range(L'A', L'C');
+  auto combination = wide.combine();
+  log.append_if("wide", !combination(L'b') || !combination(L'C') ||
+      combination(L'd'));
+
+  // Only the characters in the range that have case add anything.
+  wide.clear();
+  wide.set_icase(std::use_facet<std::ctype<wchar_t>>(loc));
+  wide.add_range(L'0', L'9');
+  wide.add_range(L'a', L'b');
+  wide.add_range(L'x', WCHAR_MAX);
+  combination = wide.combine();
+  log.append_if("wide runs", !combination(L'A') || !combination(L'B') ||
+      !combination(L'X') || !combination(L'Z') || combination(L'C') ||
+      combination(L'W') || combination(L'/') || !combination(WCHAR_MAX));
+}
@@ -5,12 +5,16 @@
 
 void matching_bracket_list_test(ttest::error_log& log);
 void non_matching_bracket_list_test(ttest::error_log& log);
+void range_bracket_list_test(ttest::error_log& log);
+void icase_bracket_list_test(ttest::error_log& log);
 
 inline ttest::test_suite::pointer create_bracket_list_test() {
   using ttest::create_test;
   return create_test("bracket list", {
       create_test("matching", matching_bracket_list_test),
-      create_test("non-matching", non_matching_bracket_list_test)
+      create_test("non-matching", non_matching_bracket_list_test),
+      create_test("range", range_bracket_list_test),
+      create_test("icase", icase_bracket_list_test)
   });
 }
 #endif// _bracket_list_test_h_
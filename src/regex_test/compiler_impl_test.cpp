@@ -64,9 +64,40 @@ void compiler_get_element_test(ttest::error_log& log) {
     });
 }
 
+void compiler_bracket_test(ttest::error_log& log) {
+  get_element_test<char>(log, "[a-c_]", regex_constants::extended, "_d", {
+      match_state::FINAL_MATCH, match_state::MISMATCH
+    });
+  get_element_test<char>(log, "[^[:space:]]", regex_constants::extended, 
+      " ", {
+      match_state::MISMATCH
+    });
+  get_element_test<char>(log, "[[.hyphen.]]", regex_constants::extended, 
+      "-", {
+      match_state::FINAL_MATCH
+    });
+
+  std::vector<std::pair<string, regex_constants::error_type>> errors {
+    {"[z-a]", regex_constants::error_range},
+    {"[[:nothing:]]", regex_constants::error_ctype},
+    {"[[.nothing.]]", regex_constants::error_collate},
+    {"[ab", regex_constants::error_brack}
+  };
+  regex_traits<char> traits;
+  for (const auto& error : errors) {
+    auto char_source = make_character_source(error.first, traits);
+    regex_constants::error_type ec {regex_constants::error_none};
+    compiler_impl<decltype(char_source)> compiler(char_source, ec, 
+        regex_constants::extended);
+    log.append_if("no error: " + error.first, compiler.get_element() || 
+        ec != error.second);
+  }
+}
+
 ttest::test_suite::pointer create_compiler_impl_test() {
   using ttest::create_test;
   return create_test("compiler_impl", {
-      create_test("get_element", compiler_get_element_test)
+      create_test("get_element", compiler_get_element_test),
+      create_test("brackets", compiler_bracket_test)
     });
 }
@@ -105,7 +105,8 @@ void char_interpreter_extended(ttest::error_log& log) {
         Token<char>((size_t) 2, token_type::REP_UPPER),
         });
   verify_correct_tokens<char>(log, "ab{1}", syntax_option_type::extended, {
-        Token<char>("ab", token_type::STRING_LITERAL),
+        Token<char>("a", token_type::STRING_LITERAL),
+        Token<char>("b", token_type::STRING_LITERAL),
         Token<char>((size_t) 1, token_type::REP_LOWER),
         Token<char>((size_t) 1, token_type::REP_UPPER),
         });
@@ -121,6 +122,13 @@ void char_interpreter_extended(ttest::error_log& log) {
         Token<char>((size_t) 1, token_type::REP_LOWER),
         Token<char>(MAX, token_type::REP_UPPER),
       });
+  verify_correct_tokens<char>(log, "if+x", syntax_option_type::extended, {
+        Token<char>("i", token_type::STRING_LITERAL),
+        Token<char>("f", token_type::STRING_LITERAL),
+        Token<char>((size_t) 1, token_type::REP_LOWER),
+        Token<char>(MAX, token_type::REP_UPPER),
+        Token<char>("x", token_type::STRING_LITERAL),
+      });
   verify_correct_tokens<char>(log, "\n\\", syntax_option_type::egrep, {
         Token<char>('\n', token_type::ALTERNATION),
         Token<char>('\\', token_type::TRAILING_ESCAPE),
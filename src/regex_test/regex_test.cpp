@@ -5,8 +5,11 @@
 #include "bracket_test.h"
 #include "bracket_list_test.h"
 
+#include <cstddef>
 #include <regex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <iostream>
 
@@ -106,6 +109,157 @@ void regex_match_test(ttest::error_log& log) {
     log.append("char class");
   }
 
+  // A copy shares the compiled program but not the run state.
+  const regex<char> shared(reg3);
+  auto state = shared.make_state();
+  auto other_state = reg3.make_state();
+  it = shared.match(b, test_string.end(), state);
+  if (it != b + 5) {
+    log.append("const match");
+  }
+  if (shared.match(b + 5, test_string.end(), other_state) != b + 5) {
+    log.append("const mismatch");
+  }
+  if (shared.match(b + 2, test_string.end(), state) != b + 5) {
+    log.append("reused state");
+  }
+  if (&shared.get_program() != &reg3.get_program()) {
+    log.append("program not shared");
+  }
+
+  // Only a small program is run bit-parallel.
+  log.append_if("small regex", !state.bit_parallel());
+  regex<char> large(std::string(80, 'a'));
+  auto large_state = large.make_state();
+  log.append_if("large regex", large_state.bit_parallel());
+  test_string = std::string(81, 'a');
+  log.append_if("large match", large.match(test_string.begin(),
+        test_string.end(), large_state) != test_string.begin() + 80);
+}
+
+// One const regex serves several threads, each with its own run state.
+void regex_thread_test(ttest::error_log& log) {
+  const regex<char> shared("(ab|a)*c");
+  std::string text("ababaabc");
+  std::vector<std::size_t> lengths(8, 0);
+
+  std::vector<std::thread> workers;
+  for (std::size_t i = 0; i < lengths.size(); ++i) {
+    workers.emplace_back([&shared, &text, &lengths, i] () {
+      auto state = shared.make_state();
+      for (int repeat = 0; repeat < 100; ++repeat) {
+        auto it = shared.match(text.begin(), text.end(), state);
+        lengths[i] = it - text.begin();
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  for (auto length : lengths) {
+    if (length != text.size()) {
+      log.append("thread result");
+    }
+  }
+}
+
+void regex_search_test(ttest::error_log& log) {
+  regex<char> reg(std::string("ERROR \\w+"), regex_constants::ECMAScript);
+  log.append_if("prefix", reg.prefix() != "ERROR ");
+  std::string text("ok\nERROR\nERROR disk full\n");
+  auto found = reg.search(text.begin(), text.end());
+  log.append_if("found", found.first - text.begin() != 9 ||
+      std::string(found.first, found.second) != "ERROR disk");
+  std::string clean("ok\nERROR\n");
+  found = reg.search(clean.begin(), clean.end());
+  log.append_if("not found", 
+      found.first != clean.end() || found.second != clean.end());
+
+  regex<char> any(std::string("\\d+"), regex_constants::ECMAScript);
+  std::string numbers("abc 42");
+  found = any.search(numbers.begin(), numbers.end());
+  log.append_if("no prefix", std::string(found.first, found.second) != "42");
+}
+
+void regex_bracket_test(ttest::error_log& log) {
+  regex<char> ident("[_a-zA-Z$][_a-zA-Z0-9$]*");
+  std::string text("_Id$9+x");
+  log.append_if("identifier",
+      ident.match(text.begin(), text.end()) != text.begin() + 5);
+  text = "9x";
+  log.append_if("leading digit",
+      ident.match(text.begin(), text.end()) != text.begin());
+
+  regex<char> negated("[^]a-c-]+");
+  text = "xyz]";
+  log.append_if("negated",
+      negated.match(text.begin(), text.end()) != text.begin() + 3);
+  text = "-";
+  log.append_if("negated dash",
+      negated.match(text.begin(), text.end()) != text.begin());
+
+  regex<char> classes("[[:digit:][:upper:]]+");
+  text = "4A2b";
+  log.append_if("classes",
+      classes.match(text.begin(), text.end()) != text.begin() + 3);
+
+  regex<wchar_t> wide(std::wstring(L"[^\x3b1-\x3c9 ]+"));
+  std::wstring wide_text(L"ab\x3b2 c");
+  log.append_if("wide",
+      wide.match(wide_text.begin(), wide_text.end()) != wide_text.begin() + 2);
+}
+
+// Case is folded into the program, so 's' and 'S' fall in one byte class
+// and the automata never see the difference.
+void regex_icase_test(ttest::error_log& log) {
+  regex<char> keyword("select|from", regex_constants::icase);
+  std::string text("SeLeCt *");
+  log.append_if("keyword",
+      keyword.match(text.begin(), text.end()) != text.begin() + 6);
+  text = "FROM";
+  log.append_if("upper keyword",
+      keyword.match(text.begin(), text.end()) != text.end());
+  const auto& prog = keyword.get_program();
+  log.append_if("byte classes", prog.byte_class('s') != prog.byte_class('S') ||
+      prog.byte_class('s') == prog.byte_class('e'));
+
+  regex<char> sensitive("select|from");
+  log.append_if("case sensitive",
+      sensitive.match(text.begin(), text.end()) != text.begin());
+
+  regex<char> brackets("[a-c_]+x", regex_constants::icase);
+  text = "aBc_X";
+  log.append_if("bracket",
+      brackets.match(text.begin(), text.end()) != text.end());
+  regex<char> negated("[^a]+", regex_constants::icase);
+  text = "bcA";
+  log.append_if("negated bracket",
+      negated.match(text.begin(), text.end()) != text.begin() + 2);
+
+  regex<char> lower("\\l+", regex_constants::ECMAScript | 
+      regex_constants::icase);
+  text = "aBc1";
+  log.append_if("class",
+      lower.match(text.begin(), text.end()) != text.begin() + 3);
+}
+
+// Compiling under an arena must give the same program as compiling on the
+// heap, and nothing compiled may depend on the arena afterward.
+void regex_arena_test(ttest::error_log& log) {
+  std::string pattern("(ab|a)*c|x{2,3}|[[:alpha:]]+");
+  regex<char> heap(pattern, regex_constants::ECMAScript);
+  optional<regex<char>> compiled;
+  {
+    arena region;
+    arena_scope scope(region);
+    compiled = regex<char>(pattern, regex_constants::ECMAScript);
+    log.append_if("arena unused", region.bytes_allocated() == 0);
+  }
+  log.append_if("program size", 
+      compiled->get_program().size() != heap.get_program().size());
+  std::string text("ababaabc");
+  log.append_if("match", compiled->match(text.begin(), text.end()) != 
+      heap.match(text.begin(), text.end()));
 }
 
 void regex_test(ttest::error_log& log) {
@@ -130,6 +284,11 @@ ttest::test_suite::pointer create_regex_test() {
   return create_test("regex module", {
       create_test("Size Display\n", size_display),
       create_test("regex::match", regex_match_test),
+      create_test("shared regex", regex_thread_test),
+      create_test("regex::search", regex_search_test),
+      create_test("brackets", regex_bracket_test),
+      create_test("icase", regex_icase_test),
+      create_test("regex in arena", regex_arena_test),
       create_test("regex", regex_test)
   });
 }
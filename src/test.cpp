@@ -8,6 +8,8 @@
 ttest::test_suite::pointer create_data_structures_module_test();
 ttest::test_suite::pointer create_matcher_module_test();
 ttest::test_suite::pointer create_regex_module_test();
+ttest::test_suite::pointer create_automaton_module_test();
+ttest::test_suite::pointer create_lex_module_test();
 
 int main() {
   using std::cerr;
@@ -17,7 +19,9 @@ int main() {
   auto lib_test = create_test("lib", {
       create_data_structures_module_test(),
       create_matcher_module_test(),
-      create_regex_module_test()
+      create_regex_module_test(),
+      create_automaton_module_test(),
+      create_lex_module_test()
     });
 
   lib_test->run_test();
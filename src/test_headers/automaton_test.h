@@ -0,0 +1,64 @@
+/* This file holds the helpers shared by the automaton tests.
+ */
+
+#ifndef _automaton_test_h_
+#define _automaton_test_h_
+
+#include "automaton/program.h"
+#include "regex/character_source.h"
+#include "regex/compiler.h"
+#include "regex_types.h"
+
+#include <cstddef>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+// This compiles a pattern into a program the way a regex does, by default
+// with the ECMAScript syntax.
+template <typename CharT>
+lex::program<CharT, std::regex_traits<CharT>>
+compile(const std::basic_string<CharT>& pattern,
+    lex::regex_constants::syntax_option_type syntax =
+      lex::regex_constants::ECMAScript) {
+  // The predicates of the program refer to the traits.
+  static std::regex_traits<CharT> traits;
+  auto source = lex::make_character_source(pattern, traits);
+  lex::regex_constants::error_type ec {lex::regex_constants::error_none};
+  lex::compiler<decltype(source)> reg_compiler(source, ec, syntax);
+  return *reg_compiler.compile_program();
+}
+
+template <typename CharT>
+lex::program<CharT, std::regex_traits<CharT>>
+compile(const CharT* pattern,
+    lex::regex_constants::syntax_option_type syntax =
+      lex::regex_constants::ECMAScript) {
+  return compile(std::basic_string<CharT>(pattern), syntax);
+}
+
+// The engines that hold on to their program take it shared.
+template <typename Pattern>
+auto compile_shared(const Pattern& pattern,
+    lex::regex_constants::syntax_option_type syntax =
+      lex::regex_constants::ECMAScript) {
+  using program_type = decltype(compile(pattern, syntax));
+  return std::make_shared<const program_type>(compile(pattern, syntax));
+}
+
+// The rules are joined the same way a translator joins them. Rule r is
+// labeled r.
+inline lex::program<char, std::regex_traits<char>>
+join_rules(const std::vector<std::string>& rules,
+    lex::regex_constants::syntax_option_type syntax =
+      lex::regex_constants::ECMAScript) {
+  lex::program_builder<char, std::regex_traits<char>> builder;
+  for (std::size_t rule = 0; rule < rules.size(); ++rule) {
+    builder.append_rule(compile(rules[rule], syntax), rule,
+        rule + 1 == rules.size());
+  }
+  return builder.release();
+}
+
+#endif// _automaton_test_h_